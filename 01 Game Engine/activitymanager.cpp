@@ -0,0 +1,113 @@
+#include "activitymanager.h"
+
+namespace
+{
+//Bodies don't get far in a few steps, so the full scan doesn't have to run every frame
+const PxU32 ScanInterval = 8;
+}
+
+void ActivityManager::setup(PxScene* scene, PxReal radius, PxReal hysteresis, Policy policy)
+{
+    mScene = scene;
+    mRadius = radius;
+    mHysteresis = hysteresis;
+    mPolicy = policy;
+}
+
+void ActivityManager::update(const PxVec3& center)
+{
+    if(!enabled() || mFrame++ % ScanInterval != 0)
+        return;
+
+    //Parked bodies that are back in range
+    const PxReal wakeDistance = mRadius * mRadius;
+    for(auto it = mParked.begin(); it != mParked.end();)
+    {
+        if((it->first->getGlobalPose().p - center).magnitudeSquared() < wakeDistance)
+        {
+            restore(it->first, it->second);
+            it = mParked.erase(it);
+        }
+        else if(mPolicy == Policy::Sleep && !it->first->isSleeping())
+        {
+            //Something woke it (a contact, a joint). It is simulating again with its own velocity,
+            //so let go of it, the scan below parks it again if it is still out of range
+            it = mParked.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    //Bodies that wandered (or were pushed) out of range
+    const PxReal parkDistance = (mRadius + mHysteresis) * (mRadius + mHysteresis);
+    mActors.resize(mScene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+    mScene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, mActors.data(), static_cast<PxU32>(mActors.size()));
+    for(PxActor* actor : mActors)
+    {
+        PxRigidDynamic* body = static_cast<PxRigidDynamic*>(actor);
+        if(body->getRigidBodyFlags() & PxRigidBodyFlag::eKINEMATIC)
+            continue;       //kinematics are moved by the game, and parked ones are already in mParked
+        if((body->getGlobalPose().p - center).magnitudeSquared() > parkDistance)
+            park(body);
+    }
+}
+
+void ActivityManager::park(PxRigidDynamic* body)
+{
+    if(mParked.count(body))
+        return;
+    Parked parked {body->getLinearVelocity(), body->getAngularVelocity(), !body->isSleeping(),
+                   body->getRigidBodyFlags().isSet(PxRigidBodyFlag::eENABLE_CCD)};
+    switch(mPolicy)
+    {
+    case Policy::Sleep:
+        if(parked.bWasAwake)
+            body->putToSleep();
+        break;
+    case Policy::Kinematic:
+        if(parked.bHadCCD)
+            body->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, false);
+        body->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, true);
+        break;
+    case Policy::Remove:
+        mScene->removeActor(*body);
+        break;
+    }
+    mParked.emplace(body, parked);
+}
+
+void ActivityManager::restore(PxRigidDynamic* body, const Parked& parked)
+{
+    switch(mPolicy)
+    {
+    case Policy::Sleep:
+        break;
+    case Policy::Kinematic:
+        body->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, false);
+        if(parked.bHadCCD)
+            body->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, true);
+        break;
+    case Policy::Remove:
+        mScene->addActor(*body);
+        break;
+    }
+    if(!parked.bWasAwake)
+        return;
+    body->setLinearVelocity(parked.linearVelocity);
+    body->setAngularVelocity(parked.angularVelocity);
+    body->wakeUp();
+}
+
+void ActivityManager::restoreAll()
+{
+    for(const auto& parked : mParked)
+        restore(parked.first, parked.second);
+    mParked.clear();
+}
+
+void ActivityManager::forget(PxRigidActor* actor)
+{
+    PxRigidDynamic* body = actor->is<PxRigidDynamic>();
+    if(body)
+        mParked.erase(body);
+}
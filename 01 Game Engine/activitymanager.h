@@ -0,0 +1,51 @@
+#ifndef ACTIVITYMANAGER_H
+#define ACTIVITYMANAGER_H
+
+#include <unordered_map>
+#include <vector>
+#include <PxPhysicsAPI.h>
+#include "physicsconfig.h"
+
+using namespace physx;
+
+//Stops simulating dynamics that are far from the player. Bodies further than radius + hysteresis
+//from the center are parked by the policy, and brought back (with the velocity they had)
+//once they are inside radius again. The gap between the two keeps bodies on the edge from
+//flipping every frame.
+class ActivityManager
+{
+public:
+    using Policy = PhysicsConfig::ActivityPolicy;
+
+    void setup(PxScene* scene, PxReal radius, PxReal hysteresis, Policy policy);
+    //Once pr step, before simulate(). The scene is only scanned every few calls
+    void update(const PxVec3& center);
+    //Brings every parked body back, e.g. before saving the scene
+    void restoreAll();
+    //The actor is being released, don't touch it again
+    void forget(PxRigidActor* actor);
+
+    bool enabled() const {return mRadius > 0.f;}
+    size_t parkedCount() const {return mParked.size();}
+
+private:
+    struct Parked
+    {
+        PxVec3 linearVelocity;
+        PxVec3 angularVelocity;
+        bool bWasAwake;
+        bool bHadCCD;       //Kinematic policy, PhysX won't take a kinematic with CCD on
+    };
+    void park(PxRigidDynamic* body);
+    void restore(PxRigidDynamic* body, const Parked& parked);
+
+    PxScene* mScene {nullptr};
+    PxReal mRadius {0.f};
+    PxReal mHysteresis {0.f};
+    Policy mPolicy {Policy::Sleep};
+    PxU32 mFrame {0};
+    std::unordered_map<PxRigidDynamic*, Parked> mParked;
+    std::vector<PxActor*> mActors;      //scratch for scanning the scene
+};
+
+#endif // ACTIVITYMANAGER_H
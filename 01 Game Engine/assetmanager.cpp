@@ -0,0 +1,32 @@
+#include "assetmanager.h"
+
+AssetManager* AssetManager::getInstance()
+{
+    static AssetManager instance;
+    return &instance;
+}
+
+void AssetManager::queueFinish(std::function<void()> finish)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFinishQueue.push_back(std::move(finish));
+}
+
+void AssetManager::update(qint64 budgetNs)
+{
+    mTimer.restart();
+    //Always finish at least one asset per frame so a tiny budget can't stall loading
+    do
+    {
+        std::function<void()> finish;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(mFinishQueue.empty())
+                return;
+            finish = std::move(mFinishQueue.front());
+            mFinishQueue.pop_front();
+        }
+        finish();
+    }
+    while(mTimer.nsecsElapsed() < budgetNs);
+}
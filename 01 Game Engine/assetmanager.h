@@ -0,0 +1,91 @@
+#ifndef ASSETMANAGER_H
+#define ASSETMANAGER_H
+
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include "jobsystem.h"
+
+enum class AssetState
+{
+    Queued,         //waiting for a worker
+    Loading,        //parsing/decoding/cooking on a worker
+    Uploading,      //waiting for its GL/PhysX step on the owning thread
+    Ready,
+    Failed
+};
+
+//Handle the caller keeps to see how far a load has come
+template<typename T>
+class Asset
+{
+public:
+    AssetState state() const {return mState;}
+    bool isReady() const {return mState == AssetState::Ready;}
+    bool failed() const {return mState == AssetState::Failed;}
+    T* get() const {return isReady() ? mData : nullptr;}
+
+private:
+    friend class AssetManager;
+    std::atomic<AssetState> mState {AssetState::Queued};
+    T* mData {nullptr};
+};
+
+template<typename T>
+using AssetHandle = std::shared_ptr<Asset<T>>;
+
+//Splits every load into two steps:
+// work   - runs on the JobSystem, must not touch OpenGL or add anything to the PxScene
+// finish - runs on the owning (GUI) thread from update(), inside a per frame time budget
+class AssetManager
+{
+public:
+    static AssetManager* getInstance();
+
+    template<typename T>
+    AssetHandle<T> load(std::function<T*()> work, std::function<bool(T*)> finish);
+
+    //Call once per frame from the owning thread
+    void update(qint64 budgetNs);
+    bool idle() const {return mPending == 0;}
+
+private:
+    AssetManager() {}
+    void queueFinish(std::function<void()> finish);
+
+    std::deque<std::function<void()>> mFinishQueue;
+    std::mutex mMutex;
+    std::atomic<int> mPending {0};
+    QElapsedTimer mTimer;
+};
+
+template<typename T>
+AssetHandle<T> AssetManager::load(std::function<T*()> work, std::function<bool(T*)> finish)
+{
+    AssetHandle<T> handle = std::make_shared<Asset<T>>();
+    mPending++;
+    JobSystem::getInstance()->schedule([this, handle, work, finish]()
+    {
+        handle->mState = AssetState::Loading;
+        T* data = work();
+        if(!data)
+        {
+            handle->mState = AssetState::Failed;
+            mPending--;
+            return;
+        }
+        handle->mData = data;
+        handle->mState = AssetState::Uploading;
+        queueFinish([this, handle, finish]()
+        {
+            handle->mState = finish(handle->mData) ? AssetState::Ready : AssetState::Failed;
+            mPending--;
+        });
+    });
+    return handle;
+}
+
+#endif // ASSETMANAGER_H
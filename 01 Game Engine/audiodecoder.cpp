@@ -0,0 +1,185 @@
+#include "audiodecoder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#define DR_WAV_IMPLEMENTATION
+#include "dr_wav.h"
+#define DR_FLAC_IMPLEMENTATION
+#include "dr_flac.h"
+#include "stb_vorbis.c"
+
+AudioDecoder::~AudioDecoder()
+{
+    close();
+}
+
+AudioDecoder::Format AudioDecoder::detect(const unsigned char* header, size_t size)
+{
+    if(size < 4)
+        return Format::None;
+    if(!std::memcmp(header, "RIFF", 4))
+        return Format::Wav;
+    if(!std::memcmp(header, "fLaC", 4))
+        return Format::Flac;
+    if(!std::memcmp(header, "OggS", 4))
+        return Format::Vorbis;
+    return Format::None;
+}
+
+bool AudioDecoder::open(const std::string& fileName)
+{
+    close();
+    unsigned char header[4] {};
+    FILE* file = std::fopen(fileName.c_str(), "rb");
+    if(!file)
+        return false;
+    size_t read = std::fread(header, 1, sizeof(header), file);
+    std::fclose(file);
+
+    mFormat = detect(header, read);
+    switch(mFormat)
+    {
+    case Format::Wav:
+        if(!drwav_init_file(&mWav, fileName.c_str(), nullptr))
+            mFormat = Format::None;
+        break;
+    case Format::Flac:
+        mFlac = drflac_open_file(fileName.c_str(), nullptr);
+        break;
+    case Format::Vorbis:
+        mVorbis = stb_vorbis_open_filename(fileName.c_str(), nullptr, nullptr);
+        break;
+    case Format::None:
+        break;
+    }
+    return finishOpen();
+}
+
+bool AudioDecoder::open(const void* data, size_t size)
+{
+    close();
+    mFormat = detect(static_cast<const unsigned char*>(data), size);
+    switch(mFormat)
+    {
+    case Format::Wav:
+        if(!drwav_init_memory(&mWav, data, size, nullptr))
+            mFormat = Format::None;
+        break;
+    case Format::Flac:
+        mFlac = drflac_open_memory(data, size, nullptr);
+        break;
+    case Format::Vorbis:
+        mVorbis = stb_vorbis_open_memory(static_cast<const unsigned char*>(data), static_cast<int>(size), nullptr, nullptr);
+        break;
+    case Format::None:
+        break;
+    }
+    return finishOpen();
+}
+
+bool AudioDecoder::finishOpen()
+{
+    switch(mFormat)
+    {
+    case Format::Wav:
+        mChannels = mWav.channels;
+        mSampleRate = mWav.sampleRate;
+        mTotalFrames = mWav.totalPCMFrameCount;
+        break;
+    case Format::Flac:
+        if(!mFlac)
+            break;
+        mChannels = mFlac->channels;
+        mSampleRate = mFlac->sampleRate;
+        mTotalFrames = mFlac->totalPCMFrameCount;
+        break;
+    case Format::Vorbis:
+    {
+        if(!mVorbis)
+            break;
+        stb_vorbis_info info = stb_vorbis_get_info(mVorbis);
+        mChannels = static_cast<unsigned int>(info.channels);
+        mSampleRate = info.sample_rate;
+        mTotalFrames = stb_vorbis_stream_length_in_samples(mVorbis);
+        break;
+    }
+    case Format::None:
+        break;
+    }
+    if(mChannels < 1 || mChannels > 2)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AudioDecoder::close()
+{
+    switch(mFormat)
+    {
+    case Format::Wav:
+        drwav_uninit(&mWav);
+        break;
+    case Format::Flac:
+        if(mFlac)
+            drflac_close(mFlac);
+        break;
+    case Format::Vorbis:
+        if(mVorbis)
+            stb_vorbis_close(mVorbis);
+        break;
+    case Format::None:
+        break;
+    }
+    mFormat = Format::None;
+    mFlac = nullptr;
+    mVorbis = nullptr;
+    mChannels = 0;
+    mSampleRate = 0;
+    mTotalFrames = 0;
+}
+
+std::uint64_t AudioDecoder::read(std::uint64_t frames, std::int16_t* out)
+{
+    switch(mFormat)
+    {
+    case Format::Wav:
+        return drwav_read_pcm_frames_s16(&mWav, frames, out);
+    case Format::Flac:
+        return drflac_read_pcm_frames_s16(mFlac, frames, out);
+    case Format::Vorbis:
+    {
+        //stb_vorbis counts in shorts and takes an int, so big reads go in pieces
+        std::uint64_t done = 0;
+        while(done < frames)
+        {
+            int shorts = static_cast<int>(std::min<std::uint64_t>(frames - done, 1 << 20) * mChannels);
+            int got = stb_vorbis_get_samples_short_interleaved(mVorbis, static_cast<int>(mChannels), out + done * mChannels, shorts);
+            if(got <= 0)
+                break;
+            done += static_cast<std::uint64_t>(got);
+        }
+        return done;
+    }
+    case Format::None:
+        break;
+    }
+    return 0;
+}
+
+bool AudioDecoder::seekToStart()
+{
+    switch(mFormat)
+    {
+    case Format::Wav:
+        return drwav_seek_to_pcm_frame(&mWav, 0);
+    case Format::Flac:
+        return drflac_seek_to_pcm_frame(mFlac, 0);
+    case Format::Vorbis:
+        return stb_vorbis_seek_start(mVorbis) != 0;
+    case Format::None:
+        break;
+    }
+    return false;
+}
@@ -0,0 +1,62 @@
+#ifndef AUDIODECODER_H
+#define AUDIODECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "dr_wav.h"
+//drflac is an anonymous struct typedef, it can't be forward declared. stb_vorbis is a real struct
+#include "dr_flac.h"
+
+struct stb_vorbis;
+
+//Reads WAV (dr_wav), FLAC (dr_flac) or Ogg Vorbis (stb_vorbis) as 16 bit interleaved frames,
+//a piece at a time. Which one is picked from the first bytes of the file, not the extension.
+//Used whole by AudioFile for short sounds and chunk by chunk by AudioStream for long ones.
+//Only mono and stereo, that is all OpenAL plays without extensions
+class AudioDecoder
+{
+public:
+    enum class Format
+    {
+        None,
+        Wav,
+        Flac,
+        Vorbis
+    };
+
+    AudioDecoder() {}
+    ~AudioDecoder();
+    AudioDecoder(const AudioDecoder&) = delete;
+    AudioDecoder& operator=(const AudioDecoder&) = delete;
+
+    //Reads from disk as it goes
+    bool open(const std::string& fileName);
+    //From memory that has to stay around until close(), e.g. a mapped file
+    bool open(const void* data, size_t size);
+    void close();
+
+    Format format() const {return mFormat;}
+    unsigned int channels() const {return mChannels;}
+    unsigned int sampleRate() const {return mSampleRate;}
+    //0 if the file does not say
+    std::uint64_t totalFrames() const {return mTotalFrames;}
+
+    //Gives back how many frames were read, fewer than asked for at the end
+    std::uint64_t read(std::uint64_t frames, std::int16_t* out);
+    bool seekToStart();
+
+private:
+    static Format detect(const unsigned char* header, size_t size);
+    bool finishOpen();
+
+    Format mFormat {Format::None};
+    drwav mWav;
+    drflac* mFlac {nullptr};
+    stb_vorbis* mVorbis {nullptr};
+    unsigned int mChannels {0};
+    unsigned int mSampleRate {0};
+    std::uint64_t mTotalFrames {0};
+};
+
+#endif // AUDIODECODER_H
@@ -0,0 +1,545 @@
+#include "audioengine.h"
+#include "audiostream.h"
+#include "audiofile.h"
+#include "openalcheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+AudioEngine* AudioEngine::getInstance()
+{
+    static AudioEngine instance;
+    return &instance;
+}
+
+AudioEngine::~AudioEngine()
+{
+    release();
+}
+
+void AudioEngine::setup(unsigned int sourceCount)
+{
+    if(mDevice)
+        return;
+
+    const ALchar* defaultDeviceString = alcGetString(/*device*/nullptr, ALC_DEFAULT_DEVICE_SPECIFIER);
+    mDevice = alcOpenDevice(defaultDeviceString);
+    if(!mDevice)
+    {
+        std::cerr << "failed to get the default device for OpenAL" << std::endl;
+        return;
+    }
+    std::cout << "OpenAL device: " << alcGetString(mDevice, ALC_DEVICE_SPECIFIER) << std::endl;
+
+    mContext = alcCreateContext(mDevice, /*attrlist*/ nullptr);
+    if(!alcMakeContextCurrent(mContext))
+    {
+        std::cerr << "failed to make the OpenAL context the current context" << std::endl;
+        return;
+    }
+
+    //Devices only mix so many sources, stop at the first one that can't be made
+    mSources.reserve(sourceCount);
+    for(unsigned int i = 0; i < sourceCount; i++)
+    {
+        ALuint source;
+        alGenSources(1, &source);
+        if(alGetError() != AL_NO_ERROR)
+            break;
+        mSources.push_back(source);
+    }
+    for(int i = static_cast<int>(mSources.size()) - 1; i >= 0; i--)
+        mFreeSources.push_back(i);
+    alec(alListenerfv(AL_ORIENTATION, forwardAndUpVectors));
+    mTimer.start();
+
+    //from here on only the audio thread talks to OpenAL
+    bRunning = true;
+    mThread = std::thread(&AudioEngine::audioLoop, this);
+}
+
+void AudioEngine::release()
+{
+    if(!mDevice)
+        return;
+    if(mThread.joinable())
+    {
+        bRunning = false;
+        mThread.join();
+    }
+    //whatever was still queued, deleting buffers mostly
+    Command command;
+    while(mCommands.pop(command))
+        apply(command);
+    for(ALuint& source : mSources)
+    {
+        alec(alSourceStop(source));
+        alec(alDeleteSources(1, &source));
+    }
+    //with the sources gone nothing holds on to the buffers
+    for(AudioStream* stream : mStreams)
+        stream->stop();
+    for(auto& entry : mBuffers)
+        alec(alDeleteBuffers(1, &entry.second));
+    mBuffers.clear();
+    mSources.clear();
+    mFreeSources.clear();
+    mVoices.clear();
+    mFreeVoices.clear();
+    mVoiceIds.clear();
+    mStreams.clear();
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(mContext);
+    alcCloseDevice(mDevice);
+    mContext = nullptr;
+    mDevice = nullptr;
+}
+
+void AudioEngine::push(const Command& command)
+{
+    if(!bRunning)
+        return;
+    if(!mCommands.push(command))
+        mDropped++;
+}
+
+void AudioEngine::pushWait(const Command& command)
+{
+    while(!mCommands.push(command))
+        std::this_thread::yield();
+}
+
+void AudioEngine::audioLoop()
+{
+    while(bRunning)
+    {
+        //everything from one batch of commands is heard at the same time
+        alcSuspendContext(mContext);
+        Command command;
+        while(mCommands.pop(command))
+            apply(command);
+        update();
+        alcProcessContext(mContext);
+        std::this_thread::sleep_for(std::chrono::milliseconds(mUpdateMs));
+    }
+}
+
+void AudioEngine::apply(const Command& command)
+{
+    switch(command.type)
+    {
+    case Command::Type::Listener:
+        mListener = command.position;
+        alec(alListener3f(AL_POSITION, command.position.x(), command.position.y(), command.position.z()));
+        alec(alListener3f(AL_VELOCITY, command.velocity.x(), command.velocity.y(), command.velocity.z()));
+        break;
+    case Command::Type::Upload:
+    {
+        ALuint buffer = 0;
+        alec(alGenBuffers(1, &buffer));
+        alec(alBufferData(buffer, command.file->format(), command.file->data(), command.file->bytes(), command.file->sampleRate()));
+        mBuffers[command.buffer] = buffer;
+        delete command.file;
+        break;
+    }
+    case Command::Type::Play:
+    {
+        auto buffer = mBuffers.find(command.buffer);
+        if(buffer == mBuffers.end())
+            break;
+        VoiceSlot& voice = newVoice(command.voice);
+        voice.buffer = buffer->second;
+        voice.position = command.position;
+        voice.gain = command.gain;
+        voice.priority = command.priority;
+        voice.bLooping = command.bLooping;
+        voice.bRelative = command.bRelative;
+
+        ALint size = 0, channels = 1, bits = 16, frequency = 1;
+        alec(alGetBufferi(voice.buffer, AL_SIZE, &size));
+        alec(alGetBufferi(voice.buffer, AL_CHANNELS, &channels));
+        alec(alGetBufferi(voice.buffer, AL_BITS, &bits));
+        alec(alGetBufferi(voice.buffer, AL_FREQUENCY, &frequency));
+        voice.duration = float(size) / std::max(channels * bits / 8 * frequency, 1);
+
+        //Straight to a source when one is free, else it waits virtual for update() to rank it
+        if(score(voice) >= mAudibleThreshold)
+            makeReal(voice);
+        break;
+    }
+    case Command::Type::Stream:
+        startStream(command);
+        break;
+    case Command::Type::CloseStream:
+        mStreams.erase(std::remove(mStreams.begin(), mStreams.end(), command.stream), mStreams.end());
+        if(find(command.voice))
+            finish(mVoiceIds[command.voice.id]);
+        //finish() took the buffers off the source, so they can go
+        command.stream->stop();
+        command.done->store(true);
+        break;
+    case Command::Type::Stop:
+        if(find(command.voice))
+            finish(mVoiceIds[command.voice.id]);
+        break;
+    case Command::Type::DeleteBuffer:
+    {
+        auto buffer = mBuffers.find(command.buffer);
+        if(buffer == mBuffers.end())
+            break;
+        for(unsigned int i = 0; i < mVoices.size(); i++)
+        {
+            if(mVoices[i].bBusy && mVoices[i].buffer == buffer->second)
+                finish(i);
+        }
+        alec(alDeleteBuffers(1, &buffer->second));
+        mBuffers.erase(buffer);
+        break;
+    }
+    case Command::Type::Position:
+        if(VoiceSlot* voice = find(command.voice))
+        {
+            voice->position = command.position;
+            if(voice->source >= 0)
+            {
+                alec(alSource3f(mSources[voice->source], AL_POSITION, command.position.x(), command.position.y(), command.position.z()));
+            }
+        }
+        break;
+    case Command::Type::Gain:
+        if(VoiceSlot* voice = find(command.voice))
+        {
+            voice->gain = command.gain;
+            if(voice->source >= 0)
+            {
+                alec(alSourcef(mSources[voice->source], AL_GAIN, command.gain));
+            }
+        }
+        break;
+    }
+}
+
+AudioEngine::VoiceSlot* AudioEngine::find(Voice voice)
+{
+    auto found = mVoiceIds.find(voice.id);
+    if(found == mVoiceIds.end())
+        return nullptr;
+    return &mVoices[found->second];
+}
+
+const AudioEngine::VoiceSlot* AudioEngine::find(Voice voice) const
+{
+    return const_cast<AudioEngine*>(this)->find(voice);
+}
+
+const ALuint* AudioEngine::source(Voice voice) const
+{
+    const VoiceSlot* slot = find(voice);
+    if(!slot || slot->source < 0)
+        return nullptr;
+    return &mSources[slot->source];
+}
+
+AudioEngine::VoiceSlot& AudioEngine::newVoice(Voice handle)
+{
+    unsigned int index;
+    if(mFreeVoices.empty())
+    {
+        index = static_cast<unsigned int>(mVoices.size());
+        mVoices.emplace_back();
+    }
+    else
+    {
+        index = mFreeVoices.back();
+        mFreeVoices.pop_back();
+    }
+    VoiceSlot& slot = mVoices[index];
+    slot = VoiceSlot();
+    slot.id = handle.id;
+    slot.bBusy = true;
+    mVoiceIds[handle.id] = index;
+    return slot;
+}
+
+void AudioEngine::finish(unsigned int index)
+{
+    VoiceSlot& voice = mVoices[index];
+    if(voice.source >= 0)
+    {
+        ALuint source = mSources[voice.source];
+        alec(alSourceStop(source));
+        //the buffer has to be detached, else it can't be deleted while the source sits in the pool.
+        //For a stream this also empties the queue
+        alec(alSourcei(source, AL_BUFFER, 0));
+        mFreeSources.push_back(voice.source);
+        voice.source = -1;
+    }
+    voice.bBusy = false;
+    mVoiceIds.erase(voice.id);
+    mFreeVoices.push_back(index);
+}
+
+//Same falloff OpenAL uses by default (inverse distance clamped, reference distance and rolloff 1)
+float AudioEngine::score(const VoiceSlot& voice) const
+{
+    float distance = voice.bRelative ? voice.position.length() : (voice.position - mListener).length();
+    float falloff = 1.f / (1.f + std::max(distance - 1.f, 0.f));
+    return voice.priority * voice.gain * falloff;
+}
+
+//score() with the real voices ahead by mKeepMargin, what virtualize() sorts by
+float AudioEngine::rank(const VoiceSlot& voice) const
+{
+    return voice.source >= 0 ? score(voice) * mKeepMargin : score(voice);
+}
+
+bool AudioEngine::makeReal(VoiceSlot& voice)
+{
+    if(mFreeSources.empty())
+        return false;
+    voice.source = mFreeSources.back();
+    mFreeSources.pop_back();
+    ALuint source = mSources[voice.source];
+
+    //a pooled source still has whatever the last sound set on it
+    alec(alSourcei(source, AL_SOURCE_RELATIVE, voice.bRelative ? AL_TRUE : AL_FALSE));
+    alec(alSource3f(source, AL_POSITION, voice.position.x(), voice.position.y(), voice.position.z()));
+    alec(alSource3f(source, AL_VELOCITY, 0.f, 0.f, 0.f));
+    alec(alSourcef(source, AL_PITCH, 1.f));
+    alec(alSourcef(source, AL_GAIN, voice.gain));
+    alec(alSourcei(source, AL_LOOPING, voice.bLooping ? AL_TRUE : AL_FALSE));
+    if(voice.bStreaming)
+        return true;
+    alec(alSourcei(source, AL_BUFFER, static_cast<ALint>(voice.buffer)));
+    if(voice.offset > 0.f)
+    {
+        alec(alSourcef(source, AL_SEC_OFFSET, voice.offset));
+    }
+    alec(alSourcePlay(source));
+    return true;
+}
+
+void AudioEngine::makeVirtual(VoiceSlot& voice)
+{
+    ALuint source = mSources[voice.source];
+    alec(alGetSourcef(source, AL_SEC_OFFSET, &voice.offset));
+    alec(alSourceStop(source));
+    alec(alSourcei(source, AL_BUFFER, 0));
+    mFreeSources.push_back(voice.source);
+    voice.source = -1;
+}
+
+void AudioEngine::update()
+{
+    float dt = mTimer.restart() / 1000.f;
+    for(AudioStream* stream : mStreams)
+        stream->update();
+
+    for(unsigned int i = 0; i < mVoices.size(); i++)
+    {
+        VoiceSlot& voice = mVoices[i];
+        if(!voice.bBusy || voice.bStreaming)
+            continue;
+        if(voice.source >= 0)
+        {
+            ALint state;
+            alec(alGetSourcei(mSources[voice.source], AL_SOURCE_STATE, &state));
+            if(state == AL_STOPPED)
+                finish(i);
+            continue;
+        }
+        //virtual voices play on in silence
+        voice.offset += dt;
+        if(voice.offset < voice.duration)
+            continue;
+        if(voice.bLooping && voice.duration > 0.f)
+            voice.offset = std::fmod(voice.offset, voice.duration);
+        else
+            finish(i);
+    }
+    virtualize();
+
+    unsigned int real = static_cast<unsigned int>(mSources.size() - mFreeSources.size());
+    mRealVoices = real;
+    mVirtualVoices = static_cast<unsigned int>(mVoiceIds.size()) - real;
+}
+
+//The most audible voices get the sources, with a head start for the ones that have one. Streams always keep theirs
+void AudioEngine::virtualize()
+{
+    mRanked.clear();
+    size_t streams = 0;
+    for(unsigned int i = 0; i < mVoices.size(); i++)
+    {
+        if(!mVoices[i].bBusy)
+            continue;
+        if(mVoices[i].bStreaming)
+            streams++;
+        else if(rank(mVoices[i]) >= mAudibleThreshold)
+            mRanked.push_back(i);
+        else if(mVoices[i].source >= 0)
+            makeVirtual(mVoices[i]);
+    }
+    size_t real = mSources.size() > streams ? mSources.size() - streams : 0;
+    if(mRanked.size() > real)
+    {
+        std::nth_element(mRanked.begin(), mRanked.begin() + real, mRanked.end(), [this](unsigned int a, unsigned int b)
+        {
+            return rank(mVoices[a]) > rank(mVoices[b]);
+        });
+    }
+    //first free the sources of the voices that lost theirs, then hand them to the ones that won
+    for(size_t i = real; i < mRanked.size(); i++)
+    {
+        if(mVoices[mRanked[i]].source >= 0)
+            makeVirtual(mVoices[mRanked[i]]);
+    }
+    for(size_t i = 0; i < std::min(real, mRanked.size()); i++)
+    {
+        if(mVoices[mRanked[i]].source < 0)
+            makeReal(mVoices[mRanked[i]]);
+    }
+}
+
+void AudioEngine::setListener(const QVector3D& position, const QVector3D& velocity)
+{
+    Command command;
+    command.type = Command::Type::Listener;
+    command.position = position;
+    command.velocity = velocity;
+    push(command);
+}
+
+Voice AudioEngine::play(ALuint buffer, const QVector3D& position, float gain, bool bLooping, bool bRelative, float priority)
+{
+    if(buffer == 0 || !bRunning)
+        return Voice();
+    Command command;
+    command.type = Command::Type::Play;
+    command.voice.id = ++mNextVoice;
+    command.buffer = buffer;
+    command.position = position;
+    command.gain = gain;
+    command.priority = priority;
+    command.bLooping = bLooping;
+    command.bRelative = bRelative;
+    push(command);
+    return command.voice;
+}
+
+void AudioEngine::stream(AudioStream* stream, Voice& voice, float gain, bool bRelative)
+{
+    voice = Voice();
+    if(!bRunning)
+        return;
+    voice.id = ++mNextVoice;
+    Command command;
+    command.type = Command::Type::Stream;
+    command.voice = voice;
+    command.stream = stream;
+    command.gain = gain;
+    command.bRelative = bRelative;
+    //a dropped one would leave the stream without buffers
+    pushWait(command);
+}
+
+void AudioEngine::startStream(const Command& command)
+{
+    //a stream can't wait virtual, so it takes a source from the least audible voice if it has to
+    if(mFreeSources.empty())
+    {
+        int weakest = -1;
+        for(unsigned int i = 0; i < mVoices.size(); i++)
+        {
+            const VoiceSlot& voice = mVoices[i];
+            if(voice.bBusy && !voice.bStreaming && voice.source >= 0 &&
+               (weakest < 0 || score(voice) < score(mVoices[weakest])))
+                weakest = static_cast<int>(i);
+        }
+        if(weakest >= 0)
+            makeVirtual(mVoices[weakest]);
+    }
+
+    VoiceSlot& voice = newVoice(command.voice);
+    voice.gain = command.gain;
+    voice.bRelative = command.bRelative;
+    voice.bStreaming = true;
+    //looping is done by the stream itself, an AL looping source would repeat just the current chunk
+    makeReal(voice);
+    command.stream->start();
+    mStreams.push_back(command.stream);
+}
+
+void AudioEngine::closeStream(AudioStream* stream, Voice voice)
+{
+    if(!bRunning)
+        return;
+    std::atomic<bool> bDone {false};
+    Command command;
+    command.type = Command::Type::CloseStream;
+    command.stream = stream;
+    command.voice = voice;
+    command.done = &bDone;
+    //this one can't be dropped, the stream is about to go away
+    pushWait(command);
+    while(!bDone)
+        std::this_thread::yield();
+}
+
+void AudioEngine::stop(Voice voice)
+{
+    if(!voice.valid())
+        return;
+    Command command;
+    command.type = Command::Type::Stop;
+    command.voice = voice;
+    push(command);
+}
+
+ALuint AudioEngine::upload(AudioFile* file)
+{
+    if(!bRunning)
+    {
+        delete file;
+        return 0;
+    }
+    Command command;
+    command.type = Command::Type::Upload;
+    command.buffer = ++mNextBuffer;
+    command.file = file;
+    //a dropped one would leak the file
+    pushWait(command);
+    return command.buffer;
+}
+
+void AudioEngine::deleteBuffer(ALuint buffer)
+{
+    if(buffer == 0)
+        return;
+    Command command;
+    command.type = Command::Type::DeleteBuffer;
+    command.buffer = buffer;
+    push(command);
+}
+
+void AudioEngine::setPosition(Voice voice, const QVector3D& position)
+{
+    if(!voice.valid())
+        return;
+    Command command;
+    command.type = Command::Type::Position;
+    command.voice = voice;
+    command.position = position;
+    push(command);
+}
+
+void AudioEngine::setGain(Voice voice, float gain)
+{
+    if(!voice.valid())
+        return;
+    Command command;
+    command.type = Command::Type::Gain;
+    command.voice = voice;
+    command.gain = gain;
+    push(command);
+}
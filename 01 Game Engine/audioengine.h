@@ -0,0 +1,177 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <QElapsedTimer>
+#include <QVector3D>
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "spscqueue.h"
+
+class AudioFile;
+class AudioStream;
+
+//Small handle to a playing sound. Every voice gets a new id, so a handle to a sound
+//that has finished is just ignored
+struct Voice
+{
+    unsigned long long id {0};
+    bool valid() const {return id != 0;}
+};
+
+//The one OpenAL device and context for the whole engine, and a pool of sources made up front.
+//SoundComponents only own buffers and start a voice every time they play.
+//Any number of voices can play, but only the sourceCount most audible ones (priority * gain *
+//distance falloff from the listener) get a real source and are mixed. The rest are virtual:
+//their play position keeps counting, and when they become audible again they take over a
+//source from a quieter voice and carry on where they would have been. Mixing cost stays the same
+//however many emitters the scene has.
+//All the OpenAL work runs on an audio thread of its own. The functions below only push a command
+//on a lock-free queue, which the audio thread applies in batches between alcSuspendContext() and
+//alcProcessContext(), so the render thread never waits on the driver. That includes making and
+//deleting buffers, the GUI thread only ever sees the handles upload() gives out.
+//They must all be called from the same (GUI) thread, the queue has one producer
+class AudioEngine
+{
+public:
+    static AudioEngine* getInstance();
+
+    void setup(unsigned int sourceCount = 32);
+    void release();
+
+    void setListener(const QVector3D& position, const QVector3D& velocity = QVector3D());
+    //Hands a loaded file over to the audio thread, which makes the AL buffer from it and deletes the file.
+    //Returns the handle play() and deleteBuffer() take, 0 (and the file deleted) when the engine isn't running
+    ALuint upload(AudioFile* file);
+    //buffer is a handle from upload(). bRelative sources follow the listener, for music and UI sounds. Higher priority wins a
+    //source over a louder voice, 0 is never mixed
+    Voice play(ALuint buffer, const QVector3D& position, float gain = 1.f, bool bLooping = false,
+               bool bRelative = false, float priority = 1.f);
+    //A source with no buffer for the stream to queue into, the stream is updated on the audio thread
+    //from then on. Always real, it stays out of the pool until closeStream().
+    //voice is set before the stream is handed over, so update() never sees it half written
+    void stream(AudioStream* stream, Voice& voice, float gain = 1.f, bool bRelative = true);
+    //Waits for the audio thread to let go of the stream, after this it can be closed or deleted
+    void closeStream(AudioStream* stream, Voice voice);
+    void stop(Voice voice);
+    //Stops every voice playing the buffer and deletes it, on the audio thread so it happens after them.
+    //The buffers are all deleted by release() anyway
+    void deleteBuffer(ALuint buffer);
+    void setPosition(Voice voice, const QVector3D& position);
+    void setGain(Voice voice, float gain);
+
+    //From the last audio update
+    unsigned int realVoices() const {return mRealVoices;}
+    unsigned int virtualVoices() const {return mVirtualVoices;}
+    //Commands lost because the queue was full (the audio thread is stuck)
+    unsigned int droppedCommands() const {return mDropped;}
+
+    //Audio thread only (AudioStream::update()). nullptr while the voice is virtual or when it has finished
+    const ALuint* source(Voice voice) const;
+
+    //Voices quieter than this are not worth a source even when one is free
+    float mAudibleThreshold {0.001f};
+    //A voice that has a source keeps it until another is this many times more audible (or it drops
+    //this far under mAudibleThreshold), so two voices of about the same score don't swap every update
+    float mKeepMargin {1.5f};
+    int mUpdateMs {5};      //how often the audio thread wakes up
+
+private:
+    AudioEngine() {}
+    ~AudioEngine();
+
+    struct Command
+    {
+        enum class Type
+        {
+            Listener,
+            Play,
+            Upload,
+            Stream,
+            CloseStream,
+            Stop,
+            DeleteBuffer,
+            Position,
+            Gain
+        };
+        Type type {Type::Stop};
+        Voice voice;
+        ALuint buffer {0};
+        QVector3D position;
+        QVector3D velocity;
+        float gain {1.f};
+        float priority {1.f};
+        bool bLooping {false};
+        bool bRelative {false};
+        AudioStream* stream {nullptr};
+        AudioFile* file {nullptr};             //Upload deletes it when done
+        std::atomic<bool>* done {nullptr};     //set when a CloseStream has been applied
+    };
+
+    struct VoiceSlot
+    {
+        unsigned long long id {0};
+        bool bBusy {false};
+        bool bStreaming {false};    //stops and starts while it waits for data, update() leaves it alone
+        ALuint buffer {0};
+        QVector3D position;
+        float gain {1.f};
+        float priority {1.f};
+        bool bLooping {false};
+        bool bRelative {false};
+        int source {-1};            //index into mSources, -1 while virtual
+        float duration {0.f};       //seconds, of the buffer
+        float offset {0.f};         //seconds played, only kept up to date while virtual
+    };
+
+    void push(const Command& command);
+    //For the commands that can't be dropped, waits for room in the queue
+    void pushWait(const Command& command);
+    void audioLoop();
+    void apply(const Command& command);
+    void update();
+    void startStream(const Command& command);
+
+    VoiceSlot* find(Voice voice);
+    const VoiceSlot* find(Voice voice) const;
+    VoiceSlot& newVoice(Voice handle);
+    void finish(unsigned int slot);
+    float score(const VoiceSlot& voice) const;
+    float rank(const VoiceSlot& voice) const;
+    bool makeReal(VoiceSlot& voice);
+    void makeVirtual(VoiceSlot& voice);
+    void virtualize();
+
+    ALCdevice* mDevice {nullptr};
+    ALCcontext* mContext {nullptr};
+    std::vector<ALuint> mSources;
+    std::vector<int> mFreeSources;
+    std::vector<VoiceSlot> mVoices;
+    std::vector<unsigned int> mFreeVoices;
+    std::unordered_map<unsigned long long, unsigned int> mVoiceIds;     //Voice::id to mVoices
+    std::vector<unsigned int> mRanked;          //scratch for virtualize()
+    std::vector<AudioStream*> mStreams;
+    std::unordered_map<ALuint, ALuint> mBuffers;       //upload() handle to AL buffer
+    QVector3D mListener;
+    QElapsedTimer mTimer;
+
+    //GUI thread -> audio thread
+    SpscQueue<Command, 4096> mCommands;
+    unsigned long long mNextVoice {0};
+    ALuint mNextBuffer {0};
+    std::thread mThread;
+    std::atomic<bool> bRunning {false};
+    std::atomic<unsigned int> mRealVoices {0};
+    std::atomic<unsigned int> mVirtualVoices {0};
+    std::atomic<unsigned int> mDropped {0};
+    const ALfloat forwardAndUpVectors[6] =
+    {
+       0.f, 1.f, 0.f,
+       0.f, 0.f, 1.f
+    };
+};
+
+#endif // AUDIOENGINE_H
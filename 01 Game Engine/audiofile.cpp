@@ -0,0 +1,178 @@
+#include "audiofile.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include "audiodecoder.h"
+
+namespace
+{
+//Conversion buffers, one pr load running at the same time. They keep their capacity,
+//so after the first few loads converting a file allocates nothing. A long file would leave
+//its buffer that big for the rest of the game, so anything over ScratchKeepSamples is freed
+const size_t ScratchKeepSamples = 1 << 20;     //2MB, about 10 seconds of 48kHz stereo
+std::mutex gScratchMutex;
+std::vector<std::unique_ptr<std::vector<std::int16_t>>> gScratch;
+std::vector<std::vector<std::int16_t>*> gFreeScratch;
+
+std::vector<std::int16_t>* takeScratch()
+{
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    if(gFreeScratch.empty())
+    {
+        gScratch.push_back(std::make_unique<std::vector<std::int16_t>>());
+        return gScratch.back().get();
+    }
+    std::vector<std::int16_t>* scratch = gFreeScratch.back();
+    gFreeScratch.pop_back();
+    return scratch;
+}
+
+void giveScratch(std::vector<std::int16_t>* scratch)
+{
+    if(scratch->capacity() > ScratchKeepSamples)
+        std::vector<std::int16_t>().swap(*scratch);
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    gFreeScratch.push_back(scratch);
+}
+
+//WAV is little endian, and so is everything we run on
+quint32 read32(const uchar* at)
+{
+    quint32 value;
+    std::memcpy(&value, at, 4);
+    return value;
+}
+
+quint16 read16(const uchar* at)
+{
+    quint16 value;
+    std::memcpy(&value, at, 2);
+    return value;
+}
+
+ALenum alFormat(unsigned int channels, unsigned int bits)
+{
+    if(channels == 1)
+        return bits == 8 ? AL_FORMAT_MONO8 : AL_FORMAT_MONO16;
+    return bits == 8 ? AL_FORMAT_STEREO8 : AL_FORMAT_STEREO16;
+}
+}
+
+AudioFile::~AudioFile()
+{
+    close();
+}
+
+bool AudioFile::open(const std::string& fileName)
+{
+    close();
+    mFile = std::make_unique<QFile>(QString::fromStdString(fileName));
+    if(!mFile->open(QIODevice::ReadOnly))
+    {
+        std::cerr << "failed to load audio file " << fileName << std::endl;
+        mFile.reset();
+        return false;
+    }
+    mMemory = mFile->map(0, mFile->size());
+    if(!mMemory)
+    {
+        std::cerr << "failed to map audio file " << fileName << std::endl;
+        close();
+        return false;
+    }
+    if(findPcm(mMemory, mFile->size()) || convert(mMemory, mFile->size()))
+        return true;
+    std::cerr << "failed to load audio file " << fileName << std::endl;
+    close();
+    return false;
+}
+
+void AudioFile::close()
+{
+    if(mScratch)
+    {
+        giveScratch(mScratch);
+        mScratch = nullptr;
+    }
+    if(mFile)
+    {
+        if(mMemory)
+            mFile->unmap(mMemory);
+        mFile.reset();
+    }
+    mMemory = nullptr;
+    mData = nullptr;
+    mBytes = 0;
+}
+
+//Walks the RIFF chunks for fmt and data. Only plain 8/16 bit mono/stereo PCM is taken as is
+bool AudioFile::findPcm(const uchar* memory, qint64 size)
+{
+    if(size < 12 || std::memcmp(memory, "RIFF", 4) != 0 || std::memcmp(memory + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool bFormatOk = false;
+    qint64 frameBytes = 1;
+    qint64 at = 12;
+    while(at + 8 <= size)
+    {
+        const uchar* chunk = memory + at;
+        quint32 chunkSize = read32(chunk + 4);
+        qint64 body = at + 8;
+        if(!std::memcmp(chunk, "fmt ", 4) && chunkSize >= 16 && body + 16 <= size)
+        {
+            quint16 formatTag = read16(memory + body);
+            quint16 channels = read16(memory + body + 2);
+            quint32 sampleRate = read32(memory + body + 4);
+            quint16 bits = read16(memory + body + 14);
+            //WAVE_FORMAT_EXTENSIBLE keeps the real tag in the first two bytes of the sub format GUID
+            if(formatTag == 0xFFFE && chunkSize >= 40 && body + 40 <= size)
+                formatTag = read16(memory + body + 24);
+            bFormatOk = formatTag == 1 && (channels == 1 || channels == 2) && (bits == 8 || bits == 16);
+            if(!bFormatOk)
+                return false;
+            frameBytes = channels * bits / 8;
+            mFormat = alFormat(channels, bits);
+            mSampleRate = static_cast<ALsizei>(sampleRate);
+        }
+        else if(!std::memcmp(chunk, "data", 4))
+        {
+            if(!bFormatOk)
+                return false;
+            //some writers leave the size at 0 or too big when they can't seek back.
+            //OpenAL wants whole frames, a cut off file can end in the middle of one
+            qint64 bytes = chunkSize == 0 ? size - body : std::min<qint64>(chunkSize, size - body);
+            bytes -= bytes % frameBytes;
+            mData = memory + body;
+            mBytes = static_cast<ALsizei>(bytes);
+            return bytes > 0;
+        }
+        at = body + chunkSize + (chunkSize & 1);     //chunks are padded to an even size
+    }
+    return false;
+}
+
+bool AudioFile::convert(const uchar* memory, qint64 size)
+{
+    AudioDecoder decoder;
+    if(!decoder.open(memory, size_t(size)))
+        return false;
+    mScratch = takeScratch();
+    //Vorbis files don't always know their length, those grow as they go
+    std::uint64_t frames = 0;
+    std::uint64_t capacity = decoder.totalFrames() > 0 ? decoder.totalFrames() : 65536;
+    while(true)
+    {
+        mScratch->resize(size_t(capacity * decoder.channels()));
+        frames += decoder.read(capacity - frames, mScratch->data() + frames * decoder.channels());
+        if(frames < capacity || decoder.totalFrames() > 0)
+            break;
+        capacity *= 2;
+    }
+    mFormat = alFormat(decoder.channels(), 16);
+    mSampleRate = static_cast<ALsizei>(decoder.sampleRate());
+    mData = mScratch->data();
+    mBytes = static_cast<ALsizei>(frames * decoder.channels() * sizeof(std::int16_t));
+    return mBytes > 0;
+}
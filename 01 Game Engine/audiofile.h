@@ -0,0 +1,46 @@
+#ifndef AUDIOFILE_H
+#define AUDIOFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <QFile>
+#include "AL/al.h"
+
+//A short sound file mapped into memory, ready to be handed to alBufferData().
+//16 and 8 bit PCM WAVs are played straight out of the mapping, nothing is decoded or copied.
+//Anything else (FLAC, Ogg Vorbis, float or 24 bit WAV ...) is decoded to 16 bit by AudioDecoder into
+//a scratch buffer that is borrowed from a shared pool, so a big sound bank doesn't allocate one pr file.
+//open() touches no OpenAL, so it can run on a worker thread; data() stays valid until close()
+class AudioFile
+{
+public:
+    AudioFile() {}
+    ~AudioFile();
+    AudioFile(const AudioFile&) = delete;
+    AudioFile& operator=(const AudioFile&) = delete;
+
+    bool open(const std::string& fileName);
+    void close();
+
+    const void* data() const {return mData;}
+    ALsizei bytes() const {return mBytes;}
+    ALenum format() const {return mFormat;}
+    ALsizei sampleRate() const {return mSampleRate;}
+    bool converted() const {return mScratch != nullptr;}
+
+private:
+    bool findPcm(const uchar* memory, qint64 size);
+    bool convert(const uchar* memory, qint64 size);
+
+    std::unique_ptr<QFile> mFile;
+    uchar* mMemory {nullptr};
+    std::vector<std::int16_t>* mScratch {nullptr};
+    const void* mData {nullptr};
+    ALsizei mBytes {0};
+    ALenum mFormat {AL_FORMAT_MONO16};
+    ALsizei mSampleRate {0};
+};
+
+#endif // AUDIOFILE_H
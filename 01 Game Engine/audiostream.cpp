@@ -0,0 +1,179 @@
+#include "audiostream.h"
+#include <algorithm>
+#include "jobsystem.h"
+#include "openalcheck.h"
+
+AudioStream::AudioStream()
+{
+}
+
+AudioStream::~AudioStream()
+{
+    close();
+}
+
+bool AudioStream::open(const std::string& fileName, bool bLoop, float gain, bool bRelative)
+{
+    close();
+    if(!mDecoder.open(fileName))
+    {
+        std::cerr << "failed to open audio stream " << fileName << std::endl;
+        return false;
+    }
+    bOpen = true;
+    bLooping = bLoop;
+    bFinished = false;
+    bEndOfFile = false;
+    mFormat = mDecoder.channels() > 1 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+    mSampleRate = static_cast<ALsizei>(mDecoder.sampleRate());
+
+    //from here on start() and update() run on the audio thread, the first update starts the decoding
+    AudioEngine::getInstance()->stream(this, mVoice, gain, bRelative);
+    return true;
+}
+
+void AudioStream::close()
+{
+    if(!bOpen)
+        return;
+    //neither the audio thread nor a decode job may be using it when it goes away
+    AudioEngine::getInstance()->closeStream(this, mVoice);
+    JobSystem::getInstance()->wait(mDecoding);
+    mReadyChunks.clear();
+    mDecoder.close();
+    bOpen = false;
+}
+
+void AudioStream::setPosition(const QVector3D& position)
+{
+    AudioEngine::getInstance()->setPosition(mVoice, position);
+}
+
+void AudioStream::setGain(float gain)
+{
+    AudioEngine::getInstance()->setGain(mVoice, gain);
+}
+
+size_t AudioStream::readyChunks()
+{
+    std::lock_guard<std::mutex> lock(mChunkMutex);
+    return mReadyChunks.size();
+}
+
+void AudioStream::scheduleDecode()
+{
+    if(mDecoding > 0 || bEndOfFile || readyChunks() >= BufferCount)
+        return;
+    mDecoding++;
+    JobSystem::getInstance()->schedule([this]()
+    {
+        decodeChunk();
+        mDecoding--;
+    });
+}
+
+//Worker thread. Fills the chunks that have room, so one job can refill the whole ring
+void AudioStream::decodeChunk()
+{
+    while(!bEndOfFile)
+    {
+        std::vector<std::int16_t> chunk;
+        {
+            std::lock_guard<std::mutex> lock(mChunkMutex);
+            if(mReadyChunks.size() >= BufferCount)
+                return;
+            if(!mSpareChunks.empty())
+            {
+                chunk = std::move(mSpareChunks.back());
+                mSpareChunks.pop_back();
+            }
+        }
+        unsigned int channels = mDecoder.channels();
+        chunk.resize(size_t(ChunkFrames * channels));
+
+        std::uint64_t frames = mDecoder.read(ChunkFrames, chunk.data());
+        //wrap around mid chunk, so the loop point has no gap in it
+        while(frames < ChunkFrames && bLooping)
+        {
+            if(!mDecoder.seekToStart())
+                break;
+            std::uint64_t read = mDecoder.read(ChunkFrames - frames, chunk.data() + frames * channels);
+            if(read == 0)
+                break;
+            frames += read;
+        }
+        if(frames < ChunkFrames)
+        {
+            bEndOfFile = true;
+            chunk.resize(size_t(frames * channels));
+        }
+
+        std::lock_guard<std::mutex> lock(mChunkMutex);
+        if(!chunk.empty())
+            mReadyChunks.push_back(std::move(chunk));
+    }
+}
+
+void AudioStream::start()
+{
+    alec(alGenBuffers(BufferCount, mBuffers));
+    mFreeBuffers.assign(mBuffers, mBuffers + BufferCount);
+}
+
+void AudioStream::stop()
+{
+    mFreeBuffers.clear();
+    if(!mBuffers[0])
+        return;
+    alec(alDeleteBuffers(BufferCount, mBuffers));
+    std::fill(mBuffers, mBuffers + BufferCount, 0);
+}
+
+void AudioStream::update()
+{
+    if(!bOpen || bFinished)
+        return;
+    const ALuint* source = AudioEngine::getInstance()->source(mVoice);
+    if(!source)
+        return;
+
+    ALint processed = 0;
+    alec(alGetSourcei(*source, AL_BUFFERS_PROCESSED, &processed));
+    while(processed-- > 0)
+    {
+        ALuint buffer;
+        alec(alSourceUnqueueBuffers(*source, 1, &buffer));
+        mFreeBuffers.push_back(buffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mChunkMutex);
+        while(!mFreeBuffers.empty() && !mReadyChunks.empty())
+        {
+            std::vector<std::int16_t>& chunk = mReadyChunks.front();
+            ALuint buffer = mFreeBuffers.back();
+            mFreeBuffers.pop_back();
+            alec(alBufferData(buffer, mFormat, chunk.data(), static_cast<ALsizei>(chunk.size() * sizeof(std::int16_t)), mSampleRate));
+            alec(alSourceQueueBuffers(*source, 1, &buffer));
+            mSpareChunks.push_back(std::move(chunk));
+            mReadyChunks.pop_front();
+        }
+    }
+
+    ALint queued = 0;
+    ALint state = AL_STOPPED;
+    alec(alGetSourcei(*source, AL_BUFFERS_QUEUED, &queued));
+    alec(alGetSourcei(*source, AL_SOURCE_STATE, &state));
+    if(state != AL_PLAYING && queued > 0)
+    {
+        //first start, or the decoder fell behind and the source ran dry
+        alec(alSourcePlay(*source));
+    }
+    else if(queued == 0 && bEndOfFile && mDecoding == 0 && readyChunks() == 0)
+    {
+        //the source stays with the stream until close()
+        bFinished = true;
+        return;
+    }
+    scheduleDecode();
+}
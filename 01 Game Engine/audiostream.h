@@ -0,0 +1,65 @@
+#ifndef AUDIOSTREAM_H
+#define AUDIOSTREAM_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QVector3D>
+#include "AL/al.h"
+#include "audiodecoder.h"
+#include "audioengine.h"
+
+//Long sounds (music, ambience) played without loading the whole file. Anything AudioDecoder
+//reads works, so the compressed formats stay compressed on disk and in memory.
+//The file is decoded a chunk at a time on the JobSystem into a small ring of AL buffers,
+//update() (called on the AudioEngine's audio thread) queues new chunks as the source uses them up.
+//Looping wraps around inside the decoder, so the end and the start land in the same chunk and
+//there is no gap. Memory is BufferCount chunks, a few hundred KB, however long the track is
+class AudioStream
+{
+public:
+    static constexpr int BufferCount = 4;
+    static constexpr std::uint64_t ChunkFrames = 16384;     //about 0.37 s at 44.1 kHz
+
+    AudioStream();
+    ~AudioStream();
+
+    //bRelative keeps it on the listener, which is what music wants
+    bool open(const std::string& fileName, bool bLooping = true, float gain = 1.f, bool bRelative = true);
+    void close();
+    void setPosition(const QVector3D& position);
+    void setGain(float gain);
+    bool isPlaying() const {return bOpen && !bFinished;}
+
+    //Audio thread only. start() and stop() make and delete the AL buffers when the AudioEngine
+    //takes the stream on and lets it go
+    void start();
+    void stop();
+    void update();
+
+private:
+    void decodeChunk();
+    void scheduleDecode();
+    size_t readyChunks();
+
+    AudioDecoder mDecoder;
+    bool bOpen {false};
+    bool bLooping {true};
+    std::atomic<bool> bFinished {false};    //played the last chunk of a non looping file
+    std::atomic<bool> bEndOfFile {false};
+    ALenum mFormat {AL_FORMAT_STEREO16};
+    ALsizei mSampleRate {0};
+    ALuint mBuffers[BufferCount] {};        //audio thread, like mFreeBuffers
+    std::vector<ALuint> mFreeBuffers;
+    Voice mVoice;
+
+    //chunks decoded on a worker and waiting to be queued, recycled through mSpareChunks
+    std::deque<std::vector<std::int16_t>> mReadyChunks;
+    std::vector<std::vector<std::int16_t>> mSpareChunks;
+    std::mutex mChunkMutex;
+    std::atomic<size_t> mDecoding {0};  //decode jobs in flight, at most one so the decoder is never shared
+};
+
+#endif // AUDIOSTREAM_H
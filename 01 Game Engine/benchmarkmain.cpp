@@ -0,0 +1,121 @@
+//Entry point for the headless physics benchmark. Built as its own executable next to the game.
+//  --steps N            measured steps pr run (default 600)
+//  --threads 1,2,4      PxDefaultCpuDispatcher thread counts to sweep (default 1, 2, 4 ... all cores)
+//  --jobsystem 0        skip the run on the engine JobSystem
+//  --iterations 4,8     solver position iterations to sweep (default 4)
+//  --scene pyramid      only run the named scene, can be given more than once
+//  --presets file.lua   run every scene under each entry of the Presets table (physics.lua)
+//  --csv file.csv       also write the results as csv
+//  --queries N          run the scene query benchmark with N raycasts instead of the scenes
+//  --cooking N          cook N unique meshes serially and through CookingService instead of the scenes
+//  --replay file.pxb    step a snapshot saved by the game (PhysicsComponent::exportSnapshot) instead of the scenes
+//  --config file.lua    PhysicsConfig to run with (physics.lua), mostly for --replay
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "physicsbenchmark.h"
+
+namespace
+{
+template<typename T>
+std::vector<T> parseList(const char* text)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while(std::getline(stream, item, ','))
+        values.push_back(static_cast<T>(std::atoi(item.c_str())));
+    return values;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    PhysicsBenchmark::Settings settings;
+    std::string csvFile;
+    PxU32 queries = 0;
+    PxU32 cookingMeshes = 0;
+    std::string replayFile;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        if(!std::strcmp(argv[i], "--steps"))
+            settings.steps = static_cast<PxU32>(std::atoi(argv[i + 1]));
+        else if(!std::strcmp(argv[i], "--threads"))
+            settings.threadCounts = parseList<int>(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--jobsystem"))
+            settings.bJobSystem = std::atoi(argv[i + 1]) != 0;
+        else if(!std::strcmp(argv[i], "--iterations"))
+            settings.positionIterations = parseList<PxU32>(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--scene"))
+            settings.scenes.push_back(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--presets"))
+        {
+            if(!PhysicsConfig::presetsFromLua(argv[i + 1], settings.config, settings.presets))
+            {
+                std::cerr << "Could not read presets from " << argv[i + 1] << "\n";
+                return 1;
+            }
+        }
+        else if(!std::strcmp(argv[i], "--queries"))
+            queries = static_cast<PxU32>(std::atoi(argv[i + 1]));
+        else if(!std::strcmp(argv[i], "--cooking"))
+            cookingMeshes = static_cast<PxU32>(std::atoi(argv[i + 1]));
+        else if(!std::strcmp(argv[i], "--replay"))
+            replayFile = argv[i + 1];
+        else if(!std::strcmp(argv[i], "--config"))
+        {
+            if(!PhysicsConfig::fromLua(argv[i + 1], settings.config))
+            {
+                std::cerr << "Could not read config from " << argv[i + 1] << "\n";
+                return 1;
+            }
+        }
+        else if(!std::strcmp(argv[i], "--csv"))
+            csvFile = argv[i + 1];
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    PhysicsBenchmark benchmark;
+    if(queries > 0)
+    {
+        PhysicsBenchmark::print(benchmark.runQueries(queries, settings), std::cout);
+        return 0;
+    }
+    if(cookingMeshes > 0)
+    {
+        PhysicsBenchmark::print(benchmark.runCooking(cookingMeshes, settings), std::cout);
+        return 0;
+    }
+
+    std::vector<PhysicsBenchmark::Result> results;
+    if(!replayFile.empty())
+    {
+        results.emplace_back();
+        if(!benchmark.runReplay(replayFile, settings, results.back()))
+        {
+            std::cerr << "Could not load " << replayFile << "\n";
+            return 1;
+        }
+    }
+    else
+        results = benchmark.run(settings);
+    PhysicsBenchmark::print(results, std::cout);
+
+    if(!csvFile.empty())
+    {
+        std::ofstream csv(csvFile);
+        if(!csv)
+        {
+            std::cerr << "Could not write " << csvFile << "\n";
+            return 1;
+        }
+        PhysicsBenchmark::writeCsv(results, csv);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "collisionproxy.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+PxVec3 position(const Vertex& vertex)
+{
+    return PxVec3(vertex.getX(), vertex.getY(), vertex.getZ());
+}
+
+//Distance from a point inside (or on) the shape to its surface, the shapes are centered
+//at the origin of the fitting frame
+PxReal sphereGap(const PxVec3& p, PxReal radius)
+{
+    return radius - p.magnitude();
+}
+
+PxReal boxGap(const PxVec3& p, const PxVec3& halfExtents)
+{
+    return std::min({halfExtents.x - std::abs(p.x), halfExtents.y - std::abs(p.y), halfExtents.z - std::abs(p.z)});
+}
+
+PxReal capsuleGap(const PxVec3& p, int axis, PxReal radius, PxReal halfHeight)
+{
+    PxVec3 onSegment(0.f, 0.f, 0.f);
+    onSegment[axis] = PxClamp(p[axis], -halfHeight, halfHeight);
+    return radius - (p - onSegment).magnitude();
+}
+}
+
+PxGeometryHolder CollisionProxy::geometry() const
+{
+    if(type == Type::Convex)
+        return PxGeometryHolder(PxConvexMeshGeometry(hull));
+    return primitive;
+}
+
+std::vector<PxVec3> CollisionProxy::weld(const std::vector<Vertex>& vertices, PxReal distance)
+{
+    std::vector<PxVec3> welded;
+    if(distance <= 0.f)
+    {
+        for(const Vertex& vertex : vertices)
+            welded.push_back(position(vertex));
+        return welded;
+    }
+    //Snap to a grid of distance sized cells, one point pr cell
+    std::unordered_map<PxU64, PxU32> cells;
+    const PxReal scale = 1.f / distance;
+    for(const Vertex& vertex : vertices)
+    {
+        PxVec3 p = position(vertex);
+        PxU64 x = static_cast<PxU64>(static_cast<PxI64>(std::floor(p.x * scale)) & 0x1fffff);
+        PxU64 y = static_cast<PxU64>(static_cast<PxI64>(std::floor(p.y * scale)) & 0x1fffff);
+        PxU64 z = static_cast<PxU64>(static_cast<PxI64>(std::floor(p.z * scale)) & 0x1fffff);
+        PxU64 key = x | (y << 21) | (z << 42);
+        if(cells.emplace(key, static_cast<PxU32>(welded.size())).second)
+            welded.push_back(p);
+    }
+    return welded;
+}
+
+CollisionProxy CollisionProxy::fit(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                                   const Settings& settings, std::vector<PxVec3>& hullPoints)
+{
+    CollisionProxy proxy;
+    hullPoints = weld(vertices, settings.weldDistance);
+    if(hullPoints.empty())
+        return proxy;
+    proxy.type = Type::Convex;
+    if(settings.tolerance <= 0.f)
+        return proxy;
+
+    //Fitting frame from the principal axes of the points
+    PxVec3 mean(0.f);
+    for(const PxVec3& p : hullPoints)
+        mean += p;
+    mean /= PxReal(hullPoints.size());
+    PxMat33 covariance(PxZero);
+    for(const PxVec3& p : hullPoints)
+    {
+        PxVec3 d = p - mean;
+        covariance += PxMat33(d * d.x, d * d.y, d * d.z);
+    }
+    PxQuat axes;
+    PxDiagonalize(covariance, axes);
+
+    //Bounds in that frame, everything below is centered on them
+    PxBounds3 bounds = PxBounds3::empty();
+    for(const PxVec3& p : hullPoints)
+        bounds.include(axes.rotateInv(p - mean));
+    const PxVec3 center = mean + axes.rotate(bounds.getCenter());
+    const PxVec3 halfExtents = bounds.getExtents();
+    const PxReal size = halfExtents.maxElement();
+    if(size <= 0.f)
+        return proxy;
+
+    //The corners, plus the middle of every triangle so a sphere around a cube can't hide
+    //behind the corners being on its surface
+    std::vector<PxVec3> samples;
+    samples.reserve(hullPoints.size() + indices.size() / 3);
+    for(const PxVec3& p : hullPoints)
+        samples.push_back(axes.rotateInv(p - center));
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        if(indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() || indices[i + 2] >= vertices.size())
+            continue;
+        PxVec3 middle = (position(vertices[indices[i]]) + position(vertices[indices[i + 1]]) + position(vertices[indices[i + 2]])) / 3.f;
+        samples.push_back(axes.rotateInv(middle - center));
+    }
+    //Every sample inside the shape, so the worst gap is the error
+    auto worstGap = [&samples, size](auto gap)
+    {
+        PxReal worst = 0.f;
+        for(const PxVec3& p : samples)
+            worst = std::max(worst, gap(p));
+        return worst / size;
+    };
+
+    //Sphere
+    PxReal radius = 0.f;
+    for(const PxVec3& p : samples)
+        radius = std::max(radius, p.magnitude());
+    PxReal error = worstGap([radius](const PxVec3& p){ return sphereGap(p, radius); });
+    if(error <= settings.tolerance)
+    {
+        proxy.type = Type::Sphere;
+        proxy.primitive.storeAny(PxSphereGeometry(radius));
+        proxy.localPose = PxTransform(center);
+        proxy.error = error;
+        return proxy;
+    }
+
+    //Capsule along the longest axis
+    int axis = halfExtents.x >= halfExtents.y ? (halfExtents.x >= halfExtents.z ? 0 : 2) : (halfExtents.y >= halfExtents.z ? 1 : 2);
+    PxReal capsuleRadius = 0.f;
+    for(const PxVec3& p : samples)
+    {
+        PxVec3 across = p;
+        across[axis] = 0.f;
+        capsuleRadius = std::max(capsuleRadius, across.magnitude());
+    }
+    PxReal halfHeight = 0.f;
+    for(const PxVec3& p : samples)
+    {
+        PxVec3 across = p;
+        across[axis] = 0.f;
+        PxReal cap = PxSqrt(PxMax(0.f, capsuleRadius * capsuleRadius - across.magnitudeSquared()));
+        halfHeight = std::max(halfHeight, std::abs(p[axis]) - cap);
+    }
+    error = worstGap([axis, capsuleRadius, halfHeight](const PxVec3& p){ return capsuleGap(p, axis, capsuleRadius, halfHeight); });
+    if(capsuleRadius > 0.f && error <= settings.tolerance)
+    {
+        //PhysX capsules lie along X
+        const PxQuat toAxis = axis == 0 ? PxQuat(PxIdentity)
+                                        : axis == 1 ? PxQuat(PxHalfPi, PxVec3(0.f, 0.f, 1.f))
+                                                    : PxQuat(-PxHalfPi, PxVec3(0.f, 1.f, 0.f));
+        proxy.type = Type::Capsule;
+        proxy.primitive.storeAny(PxCapsuleGeometry(capsuleRadius, PxMax(halfHeight, 0.001f)));
+        proxy.localPose = PxTransform(center, axes * toAxis);
+        proxy.error = error;
+        return proxy;
+    }
+
+    //Box
+    error = worstGap([halfExtents](const PxVec3& p){ return boxGap(p, halfExtents); });
+    if(halfExtents.minElement() > 0.f && error <= settings.tolerance)
+    {
+        proxy.type = Type::Box;
+        proxy.primitive.storeAny(PxBoxGeometry(halfExtents));
+        proxy.localPose = PxTransform(center, axes);
+        proxy.error = error;
+        return proxy;
+    }
+    return proxy;
+}
@@ -0,0 +1,47 @@
+#ifndef COLLISIONPROXY_H
+#define COLLISIONPROXY_H
+
+#include <vector>
+#include <PxPhysicsAPI.h>
+#include "vertex.h"
+
+using namespace physx;
+
+//What a dynamic mesh collides as. A sphere, capsule or box when one of them stays close
+//enough to the mesh, since those are a lot cheaper for the solver than convex vs convex,
+//else a convex hull of the welded vertices.
+struct CollisionProxy
+{
+    enum class Type
+    {
+        None,
+        Sphere,
+        Capsule,
+        Box,
+        Convex      //hull is set
+    };
+    Type type {Type::None};
+    PxGeometryHolder primitive;                 //for Sphere, Capsule and Box
+    PxConvexMesh* hull {nullptr};               //carries one registry reference, like cookConvexMesh()
+    PxTransform localPose {PxIdentity};         //the shape's pose on the actor
+    PxReal error {0.f};                         //largest distance from the mesh surface, relative to the mesh size
+
+    struct Settings
+    {
+        PxReal weldDistance {0.001f};
+        PxReal tolerance {0.05f};   //largest error a primitive may have, 0 always gives a hull
+    };
+
+    bool valid() const {return type != Type::None;}
+    PxGeometryHolder geometry() const;
+
+    //Welds the vertices and tries the primitives cheapest first (sphere, capsule, box).
+    //When none of them is within tolerance, type is Convex and hullPoints holds the welded points
+    //for the caller to cook. indices are only used to sample the triangles as well as the corners.
+    static CollisionProxy fit(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                              const Settings& settings, std::vector<PxVec3>& hullPoints);
+    //Merges vertices closer than distance (UV and normal seams give lots of duplicates)
+    static std::vector<PxVec3> weld(const std::vector<Vertex>& vertices, PxReal distance);
+};
+
+#endif // COLLISIONPROXY_H
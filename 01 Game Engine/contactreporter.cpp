@@ -0,0 +1,75 @@
+#include "contactreporter.h"
+
+namespace
+{
+//Enough points for a position and impulse, the rest of a manifold adds nothing for sound or gameplay
+const PxU32 MaxPointsPrPair = 4;
+}
+
+void ContactReporter::setup(PxU32 capacity)
+{
+    mCapacity = capacity;
+    mEvents.reserve(capacity);
+}
+
+void ContactReporter::clear()
+{
+    mEvents.clear();
+    mDropped = 0;
+}
+
+void ContactReporter::push(const ContactEvent& event)
+{
+    if(mEvents.size() < mCapacity)
+        mEvents.push_back(event);
+    else
+        mDropped++;
+}
+
+void ContactReporter::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs)
+{
+    if(pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0 | PxContactPairHeaderFlag::eREMOVED_ACTOR_1))
+        return;
+
+    PxContactPairPoint points[MaxPointsPrPair];
+    for(PxU32 i = 0; i < nbPairs; i++)
+    {
+        const PxContactPair& pair = pairs[i];
+        if(!(pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND))
+            continue;
+
+        ContactEvent event;
+        event.actor0 = pairHeader.actors[0];
+        event.actor1 = pairHeader.actors[1];
+        PxU32 count = pair.extractContacts(points, MaxPointsPrPair);
+        for(PxU32 point = 0; point < count; point++)
+        {
+            event.position += points[point].position;
+            event.normal += points[point].normal;
+            event.impulse += points[point].impulse.magnitude();
+        }
+        if(count > 0)
+        {
+            event.position /= PxReal(count);
+            event.normal.normalizeSafe();
+        }
+        push(event);
+    }
+}
+
+void ContactReporter::onTrigger(PxTriggerPair* pairs, PxU32 count)
+{
+    for(PxU32 i = 0; i < count; i++)
+    {
+        const PxTriggerPair& pair = pairs[i];
+        if(pair.flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER))
+            continue;
+        ContactEvent event;
+        event.type = pair.status == PxPairFlag::eNOTIFY_TOUCH_FOUND ? ContactEvent::Type::TriggerEnter
+                                                                    : ContactEvent::Type::TriggerExit;
+        event.actor0 = pair.triggerActor;
+        event.actor1 = pair.otherActor;
+        event.position = pair.triggerActor->getGlobalPose().p;
+        push(event);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef CONTACTREPORTER_H
+#define CONTACTREPORTER_H
+
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Bits in PxFilterData::word0 of a shape's simulation filter data. The filter shader only asks
+//PhysX for contact reports on pairs where one of the shapes has ReportContacts set.
+enum ContactFilterFlags : PxU32
+{
+    ReportContacts = 1 << 0
+};
+
+//One record pr touching pair or trigger change, small enough to copy around freely
+struct ContactEvent
+{
+    enum class Type : PxU8
+    {
+        Contact,
+        TriggerEnter,
+        TriggerExit
+    };
+    Type type {Type::Contact};
+    PxRigidActor* actor0 {nullptr};     //the trigger for trigger events
+    PxRigidActor* actor1 {nullptr};
+    PxVec3 position {0.f, 0.f, 0.f};    //average of the contact points
+    PxVec3 normal {0.f, 0.f, 0.f};
+    PxReal impulse {0.f};               //summed over the contact points
+};
+
+//PhysX calls this from fetchResults() on the thread that simulates. It only writes events into
+//a buffer that is sized up front, everything that reacts to them (sound, gameplay, Lua) reads
+//the whole buffer once after the step.
+class ContactReporter : public PxSimulationEventCallback
+{
+public:
+    void setup(PxU32 capacity);
+    //Called before every simulate()
+    void clear();
+
+    const std::vector<ContactEvent>& events() const {return mEvents;}
+    std::vector<ContactEvent>& events(){return mEvents;}
+    //Events that did not fit in the buffer last step
+    PxU32 dropped() const {return mDropped;}
+
+    void onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs) override;
+    void onTrigger(PxTriggerPair* pairs, PxU32 count) override;
+    void onConstraintBreak(PxConstraintInfo*, PxU32) override {}
+    void onWake(PxActor**, PxU32) override {}
+    void onSleep(PxActor**, PxU32) override {}
+    void onAdvance(const PxRigidBody* const*, const PxTransform*, const PxU32) override {}
+
+private:
+    void push(const ContactEvent& event);
+
+    std::vector<ContactEvent> mEvents;
+    PxU32 mCapacity {0};
+    PxU32 mDropped {0};
+};
+
+#endif // CONTACTREPORTER_H
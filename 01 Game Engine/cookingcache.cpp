@@ -0,0 +1,189 @@
+#include "cookingcache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cstdio>
+
+namespace
+{
+//64 bit FNV-1a
+const PxU64 fnvOffset = 14695981039346656037ull;
+const PxU64 fnvPrime = 1099511628211ull;
+
+void hashBytes(PxU64& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+}
+
+template<typename T>
+void hashValue(PxU64& hash, const T& value)
+{
+    hashBytes(hash, &value, sizeof(T));
+}
+
+//Only the elementSize first bytes of every element, the rest of the stride can be anything
+void hashStrided(PxU64& hash, const PxBoundedData& data, size_t elementSize)
+{
+    hashValue(hash, data.count);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data.data);
+    for(PxU32 i = 0; i < data.count; i++)
+        hashBytes(hash, bytes + size_t(i) * data.stride, elementSize);
+}
+
+void hashParams(PxU64& hash, const PxCookingParams& params)
+{
+    hashValue(hash, PxU32(PX_PHYSICS_VERSION));
+    hashValue(hash, params.scale.length);
+    hashValue(hash, params.scale.speed);
+    hashValue(hash, params.areaTestEpsilon);
+    hashValue(hash, params.planeTolerance);
+    hashValue(hash, PxU32(params.convexMeshCookingType));
+    hashValue(hash, params.suppressTriangleMeshRemapTable);
+    hashValue(hash, params.buildTriangleAdjacencies);
+    hashValue(hash, params.buildGPUData);
+    hashValue(hash, PxU32(params.meshPreprocessParams));
+    hashValue(hash, params.meshWeldTolerance);
+    hashValue(hash, PxU32(params.midphaseDesc.getType()));
+    hashValue(hash, params.gaussMapLimit);
+}
+}
+
+void CookingCache::setup(PxPhysics* physics, PxCooking* cooking, const std::string& directory)
+{
+    mPhysics = physics;
+    mCooking = cooking;
+    mDirectory = directory;
+    if(!mDirectory.empty() && !QDir().mkpath(QString::fromStdString(mDirectory)))
+    {
+        std::cout << "could not make the cooking cache folder " << mDirectory << ", cooking without it\n";
+        mDirectory.clear();
+    }
+}
+
+PxU64 CookingCache::hash(const PxConvexMeshDesc& desc, const PxCookingParams& params)
+{
+    PxU64 hash = fnvOffset;
+    hashParams(hash, params);
+    hashValue(hash, PxU32(desc.flags));
+    hashValue(hash, desc.vertexLimit);
+    hashValue(hash, desc.quantizedCount);
+    hashStrided(hash, desc.points, sizeof(PxVec3));
+    //With eCOMPUTE_CONVEX the hull only depends on the points
+    if(!(desc.flags & PxConvexFlag::eCOMPUTE_CONVEX))
+    {
+        hashStrided(hash, desc.polygons, sizeof(PxHullPolygon));
+        hashStrided(hash, desc.indices, (desc.flags & PxConvexFlag::e16_BIT_INDICES) ? sizeof(PxU16) : sizeof(PxU32));
+    }
+    return hash;
+}
+
+PxU64 CookingCache::hash(const PxTriangleMeshDesc& desc, const PxCookingParams& params)
+{
+    PxU64 hash = fnvOffset;
+    hashParams(hash, params);
+    hashValue(hash, PxU32(desc.flags));
+    hashStrided(hash, desc.points, sizeof(PxVec3));
+    hashStrided(hash, desc.triangles, 3 * ((desc.flags & PxMeshFlag::e16_BIT_INDICES) ? sizeof(PxU16) : sizeof(PxU32)));
+    if(desc.materialIndices.data)
+        hashStrided(hash, desc.materialIndices, sizeof(PxMaterialTableIndex));
+    return hash;
+}
+
+PxConvexMesh* CookingCache::convexMesh(const PxConvexMeshDesc& desc)
+{
+    std::string file;
+    if(!mDirectory.empty())
+        file = fileName(hash(desc, mCooking->getParams()), ".cvx");
+
+    //PhysX reads the mesh straight from the file, no copy in memory first
+    if(!file.empty() && cachedFile(file))
+    {
+        {
+            PxDefaultFileInputData input(file.c_str());
+            if(PxConvexMesh* mesh = mPhysics->createConvexMesh(input))
+                return mesh;
+        }
+        //Stale or broken file, cooked again below. If it can't be removed it is just written over.
+        //Closed first, Windows won't remove an open file
+        QFile::remove(QString::fromStdString(file));
+    }
+
+    PxDefaultMemoryOutputStream cooked;
+    if(!mCooking->cookConvexMesh(desc, cooked))
+    {
+        std::cout << "Cooking failed";
+        return nullptr;
+    }
+    PxDefaultMemoryInputData input(cooked.getData(), cooked.getSize());
+    PxConvexMesh* mesh = mPhysics->createConvexMesh(input);
+    if(mesh && !file.empty())
+        writeFile(file, cooked);
+    return mesh;
+}
+
+PxTriangleMesh* CookingCache::triangleMesh(const PxTriangleMeshDesc& desc)
+{
+    std::string file;
+    if(!mDirectory.empty())
+        file = fileName(hash(desc, mCooking->getParams()), ".tri");
+
+    if(!file.empty() && cachedFile(file))
+    {
+        {
+            PxDefaultFileInputData input(file.c_str());
+            if(PxTriangleMesh* mesh = mPhysics->createTriangleMesh(input))
+                return mesh;
+        }
+        QFile::remove(QString::fromStdString(file));
+    }
+
+    PxDefaultMemoryOutputStream cooked;
+    PxTriangleMeshCookingResult::Enum result;
+    if(!mCooking->cookTriangleMesh(desc, cooked, &result))
+    {
+        std::cout << "cooking failed";
+        return nullptr;
+    }
+    PxDefaultMemoryInputData input(cooked.getData(), cooked.getSize());
+    PxTriangleMesh* mesh = mPhysics->createTriangleMesh(input);
+    if(mesh && !file.empty())
+        writeFile(file, cooked);
+    return mesh;
+}
+
+std::string CookingCache::fileName(PxU64 key, const char* extension) const
+{
+    std::ostringstream name;
+    name << mDirectory << "/" << std::hex << key << extension;
+    return name.str();
+}
+
+//Checked before PhysX gets the file, it only reports a broken stream for a missing or empty one
+bool CookingCache::cachedFile(const std::string& file) const
+{
+    return QFileInfo(QString::fromStdString(file)).size() > 0;
+}
+
+void CookingCache::writeFile(const std::string& file, const PxDefaultMemoryOutputStream& data) const
+{
+    //Write to a file of our own first so two threads cooking the same mesh
+    //can't leave half a file behind for the next run
+    std::ostringstream temp;
+    temp << file << "." << std::this_thread::get_id() << ".tmp";
+    {
+        PxDefaultFileOutputStream output(temp.str().c_str());
+        if(!output.isValid())
+            return;
+        output.write(data.getData(), data.getSize());
+    }
+    if(std::rename(temp.str().c_str(), file.c_str()) != 0)
+        std::remove(temp.str().c_str());    //someone else got there first
+}
@@ -0,0 +1,36 @@
+#ifndef COOKINGCACHE_H
+#define COOKINGCACHE_H
+
+#include <string>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Keeps cooked convex and triangle meshes on disk so a mesh only has to be cooked
+//the first time it is seen. The file name is a hash of the vertex/index data,
+//the mesh flags, the cooking parameters and the PhysX version,
+//so changing any of them just makes a new entry.
+//Safe to use from several worker threads at once.
+class CookingCache
+{
+public:
+    //An empty directory turns the disk cache off, meshes are then always cooked
+    void setup(PxPhysics* physics, PxCooking* cooking, const std::string& directory);
+
+    PxConvexMesh* convexMesh(const PxConvexMeshDesc& desc);
+    PxTriangleMesh* triangleMesh(const PxTriangleMeshDesc& desc);
+
+    static PxU64 hash(const PxConvexMeshDesc& desc, const PxCookingParams& params);
+    static PxU64 hash(const PxTriangleMeshDesc& desc, const PxCookingParams& params);
+
+private:
+    std::string fileName(PxU64 key, const char* extension) const;
+    bool cachedFile(const std::string& file) const;
+    void writeFile(const std::string& file, const PxDefaultMemoryOutputStream& data) const;
+
+    PxPhysics* mPhysics {nullptr};
+    PxCooking* mCooking {nullptr};
+    std::string mDirectory;
+};
+
+#endif // COOKINGCACHE_H
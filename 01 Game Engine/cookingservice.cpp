@@ -0,0 +1,59 @@
+#include "cookingservice.h"
+#include <chrono>
+#include "jobsystem.h"
+
+std::vector<CookingService::Result> CookingService::cook(const std::vector<Request>& requests)
+{
+    std::vector<Result> results(requests.size());
+    //One mesh pr job, meshes vary too much in size for bigger chunks to balance
+    JobSystem::getInstance()->parallelFor(requests.size(), [this, &requests, &results](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const Request& request = requests[i];
+            Result& result = results[i];
+            result.name = request.name;
+            result.kind = request.kind;
+            result.pose = request.pose;
+            if(!request.vertices || !request.indices)
+                continue;
+
+            auto start = std::chrono::steady_clock::now();
+            if(request.kind == Kind::Dynamic)
+                result.proxy = mPhysics.buildProxy(*request.vertices, *request.indices);
+            else
+                result.mesh = mPhysics.cookTriangleMesh(*request.vertices, *request.indices);
+            result.cookMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }, 1);
+    return results;
+}
+
+std::vector<PxRigidActor*> CookingService::insert(const std::vector<Result>& results)
+{
+    std::vector<PxRigidActor*> actors(results.size(), nullptr);
+    std::vector<PxRigidActor*> batch;
+    batch.reserve(results.size());
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const Result& result = results[i];
+        if(!result.valid())
+            continue;
+        if(result.kind == Kind::Dynamic)
+            actors[i] = mPhysics.createDynamicActor(result.proxy, result.name, result.pose);
+        else
+            actors[i] = mPhysics.createStaticActor(result.mesh, result.name, result.pose);
+        if(actors[i])
+            batch.push_back(actors[i]);
+    }
+    mPhysics.addActors(batch);
+    return actors;
+}
+
+double CookingService::totalCookMs(const std::vector<Result>& results)
+{
+    double total = 0.0;
+    for(const Result& result : results)
+        total += result.cookMs;
+    return total;
+}
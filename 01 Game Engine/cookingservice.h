@@ -0,0 +1,55 @@
+#ifndef COOKINGSERVICE_H
+#define COOKINGSERVICE_H
+
+#include <string>
+#include <vector>
+#include "physicsmanager.h"
+
+//Cooks a whole level's worth of collision meshes at once. cook() spreads the meshes over the
+//JobSystem (PxCooking is thread safe for cooking), insert() then makes the actors and adds them
+//to the scene in one go on the thread that owns it.
+class CookingService
+{
+public:
+    enum class Kind
+    {
+        Dynamic,    //CollisionProxy, see PhysicsComponent::buildProxy()
+        Static      //triangle mesh
+    };
+
+    struct Request
+    {
+        const char* name {nullptr};                 //kept by the actor, has to outlive it
+        const std::vector<Vertex>* vertices {nullptr};
+        const std::vector<GLuint>* indices {nullptr};
+        Kind kind {Kind::Dynamic};
+        PxTransform pose {PxIdentity};
+    };
+
+    struct Result
+    {
+        const char* name {nullptr};
+        Kind kind {Kind::Dynamic};
+        PxTransform pose {PxIdentity};
+        CollisionProxy proxy;                       //Dynamic
+        PxTriangleMesh* mesh {nullptr};             //Static
+        double cookMs {0.0};
+        bool valid() const {return kind == Kind::Dynamic ? proxy.valid() : mesh != nullptr;}
+    };
+
+    explicit CookingService(PhysicsComponent& physics) : mPhysics(physics) {}
+
+    //Blocks until every mesh is cooked, the calling thread helps out.
+    //The vertex/index buffers only have to live until this returns
+    std::vector<Result> cook(const std::vector<Request>& requests);
+    //Owning thread only. Gives back the actors in the same order, nullptr where cooking failed
+    std::vector<PxRigidActor*> insert(const std::vector<Result>& results);
+
+    //Sum of the pr mesh cook times, compare with the wall time to see the speedup
+    static double totalCookMs(const std::vector<Result>& results);
+
+private:
+    PhysicsComponent& mPhysics;
+};
+
+#endif // COOKINGSERVICE_H
@@ -15,12 +15,12 @@ GameObject::~GameObject()
 
 }
 
-std::vector<Vertex> GameObject::vertices() const
+const std::vector<Vertex>& GameObject::vertices() const
 {
     return graphics_->getVertices();
 }
 
-std::vector<GLuint> GameObject::indecies() const
+const std::vector<GLuint>& GameObject::indecies() const
 {
     return graphics_->getIndices();
 }
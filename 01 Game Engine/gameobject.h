@@ -23,8 +23,9 @@ public:
     GraphicsComponent *graphics() const {return graphics_;};
     PhysicsComponent* physics() const {return physics_;}
     const char* getName(){return name;}
-    std::vector<Vertex> vertices() const;
-    std::vector<GLuint> indecies() const;
+    //The render mesh, shared with physics cooking so it is never copied
+    const std::vector<Vertex>& vertices() const;
+    const std::vector<GLuint>& indecies() const;
     //Transform data
     QMatrix4x4 mMatrix;
     QMatrix4x4 mPosition;
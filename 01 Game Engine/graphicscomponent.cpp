@@ -14,6 +14,7 @@ GraphicsComponent::GraphicsComponent(std::vector<Vertex> V)
 
 //File reading, needs better condition checking
 GraphicsComponent::GraphicsComponent(std::string fileName, GLuint ShaderId, GLuint TextureId)
+    : mShaderId(ShaderId), mTextureId(TextureId)
 {
     //fbx and obj
     if(fileName.back() == 'x' || fileName.back() == 'j')
@@ -26,6 +27,9 @@ GraphicsComponent::GraphicsComponent(std::string fileName, GLuint ShaderId, GLui
 
 GraphicsComponent::~GraphicsComponent()
 {
+    //components that were only used to parse a file never got their GL functions initialized
+    if(mVAO == 0)
+        return;
     glDeleteVertexArrays( 1, &mVAO );
     glDeleteBuffers( 1, &mVBO );
 }
@@ -147,6 +151,7 @@ void GraphicsComponent::readTextFile(std::string fileName)
         {
              inn >> vertex;
              mVertices.push_back(vertex);
+             mIndices.push_back(i);   //triangle list, needed for collision cooking
         }
         inn.close();
     }
@@ -174,6 +179,23 @@ void GraphicsComponent::init(GLint matrixUniform)
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,  sizeof(Vertex),  (GLvoid*)(3 * sizeof(GLfloat)) );
     glEnableVertexAttribArray(1);
 
+    //uv, used by the texture and phong shaders (terrain)
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,  sizeof(Vertex),  (GLvoid*)(6 * sizeof(GLfloat)) );
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
+void GraphicsComponent::reload(GraphicsComponent &source)
+{
+    mVertices.swap(source.mVertices);
+    mIndices.swap(source.mIndices);
+    if(mVAO == 0)   //not uploaded yet, init() will take the new data
+        return;
+
+    glBindVertexArray( mVAO );
+    glBindBuffer( GL_ARRAY_BUFFER, mVBO );
+    glBufferData( GL_ARRAY_BUFFER, mVertices.size()*sizeof(Vertex), mVertices.data(), GL_STATIC_DRAW );
     glBindVertexArray(0);
 }
 
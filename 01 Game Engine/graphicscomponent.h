@@ -22,6 +22,11 @@ public:
     QMatrix4x4 mMatrix;
     virtual GLuint getShaderId(){return mShaderId;}
     virtual GLuint getTexId(){return mTextureId;}
+    void setShaderId(GLuint shaderId){mShaderId = shaderId;}
+    void setTextureId(GLuint textureId){mTextureId = textureId;}
+    void setMatrixUniform(GLint matrixUniform){mMatrixUniform = matrixUniform;}
+    //Takes over the mesh data of source and re-uploads it into our existing VBO
+    void reload(GraphicsComponent& source);
     void update(QMatrix4x4 model, std::vector<GLint> vMatrixUniform, std::vector<GLint> pMatrixUniform, std::vector<Shader*> shaders, Camera* mCamera, Light* light);
 
     const std::vector<Vertex> &getVertices() const;
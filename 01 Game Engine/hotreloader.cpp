@@ -0,0 +1,47 @@
+#include "hotreloader.h"
+#include <QFileInfo>
+
+HotReloader::HotReloader()
+{
+    QObject::connect(&mWatcher, &QFileSystemWatcher::fileChanged,
+                     [this](const QString& path){ fileChanged(path); });
+}
+
+void HotReloader::watch(const std::string& fileName, std::function<void()> reload)
+{
+    QString path = QString::fromStdString(fileName);
+    if(!mWatcher.files().contains(path))
+        mWatcher.addPath(path);
+    mReloads[fileName].push_back(std::move(reload));
+}
+
+void HotReloader::fileChanged(const QString& path)
+{
+    mPending[path.toStdString()].start();
+}
+
+void HotReloader::update()
+{
+    for(auto it = mPending.begin(); it != mPending.end();)
+    {
+        if(it->second.elapsed() < mSettleMs)
+        {
+            ++it;
+            continue;
+        }
+        //Many editors save by writing a new file and renaming it over the old one,
+        //which makes the watcher drop the path. Wait for the new file and add it again
+        QString path = QString::fromStdString(it->first);
+        if(!QFileInfo::exists(path))
+        {
+            ++it;
+            continue;
+        }
+        if(!mWatcher.files().contains(path))
+            mWatcher.addPath(path);
+
+        for(auto& reload : mReloads[it->first])
+            reload();
+        it = mPending.erase(it);
+    }
+}
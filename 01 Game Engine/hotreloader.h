@@ -0,0 +1,32 @@
+#ifndef HOTRELOADER_H
+#define HOTRELOADER_H
+
+#include <QFileSystemWatcher>
+#include <QElapsedTimer>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Watches asset files on disk and calls back when one of them has changed,
+//so only that asset has to be reloaded while the game keeps running.
+//QFileSystemWatcher sits on top of inotify on Linux (and the native APIs on Windows/Mac).
+class HotReloader
+{
+public:
+    HotReloader();
+    void watch(const std::string& fileName, std::function<void()> reload);
+    //Call once per frame from the GUI thread, runs the reloads for files that have stopped changing
+    void update();
+
+private:
+    void fileChanged(const QString& path);
+
+    QFileSystemWatcher mWatcher;
+    std::unordered_map<std::string, std::vector<std::function<void()>>> mReloads;
+    std::unordered_map<std::string, QElapsedTimer> mPending;
+    //Editors often write a file in several steps, wait until it has been quiet this long
+    const qint64 mSettleMs {100};
+};
+
+#endif // HOTRELOADER_H
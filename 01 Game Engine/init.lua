@@ -2,6 +2,15 @@ objects = {}
 objects[0] = { Name = "test", FilePath = "../GEA2022/assets/test.obj"}
 objects[1] = { Name = "cube", FilePath = "../GEA2022/assets/cube.obj"}
 
+-- Streamed and looped as background music (.wav, .flac or .ogg), leave it nil for silence.
+-- Object sounds are short and decoded once, music is long and decoded while it plays
+Music = nil
+
 function GetObject(n)
     return objects[n]
 end
+
+-- Called once pr frame with every contact/trigger event of the last physics step:
+-- { {A = "name", B = "name", Type = "Contact", Impulse = 0, X = 0, Y = 0, Z = 0}, ... }
+function OnContact(contacts)
+end
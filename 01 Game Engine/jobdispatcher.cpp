@@ -0,0 +1,18 @@
+#include "jobdispatcher.h"
+#include "jobsystem.h"
+
+void JobDispatcher::submitTask(PxBaseTask& task)
+{
+    //PhysX keeps the task alive until release(), which also hands its continuation back to us
+    PxBaseTask* pTask = &task;
+    JobSystem::getInstance()->schedule([pTask]()
+    {
+        pTask->run();
+        pTask->release();
+    });
+}
+
+uint32_t JobDispatcher::getWorkerCount() const
+{
+    return JobSystem::getInstance()->workerCount();
+}
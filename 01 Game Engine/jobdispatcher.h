@@ -0,0 +1,17 @@
+#ifndef JOBDISPATCHER_H
+#define JOBDISPATCHER_H
+
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Runs PhysX tasks on the engine JobSystem instead of a separate PhysX thread pool,
+//so physics and everything else share the same worker threads
+class JobDispatcher : public PxCpuDispatcher
+{
+public:
+    void submitTask(PxBaseTask& task) override;
+    uint32_t getWorkerCount() const override;
+};
+
+#endif // JOBDISPATCHER_H
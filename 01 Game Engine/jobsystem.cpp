@@ -0,0 +1,171 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+namespace
+{
+//Index of the worker running on this thread, -1 for threads outside the pool
+thread_local int tWorkerIndex = -1;
+}
+
+JobSystem* JobSystem::getInstance()
+{
+    static JobSystem instance;
+    return &instance;
+}
+
+JobSystem::JobSystem()
+{
+    //Leave one core for the GUI thread
+    unsigned int threads = std::thread::hardware_concurrency();
+    threads = threads > 1 ? threads - 1 : 1;
+    for(unsigned int i = 0; i < threads; i++)
+        mQueues.push_back(std::make_unique<Queue>());
+    for(unsigned int i = 0; i < threads; i++)
+        mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        bRunning = false;
+    }
+    mWakeUp.notify_all();
+    for(auto& worker : mWorkers)
+        worker.join();
+}
+
+void JobSystem::schedule(std::function<void()> job)
+{
+    //Jobs made by a worker stay on that worker, the rest are spread out
+    unsigned int index = tWorkerIndex >= 0 ? static_cast<unsigned int>(tWorkerIndex)
+                                           : mNextQueue++ % mQueues.size();
+    {
+        std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+        mQueues[index]->jobs.push_back(std::move(job));
+    }
+    mQueued++;
+    //Taking the lock makes sure a worker that just found nothing is already waiting
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mWakeUp.notify_one();
+}
+
+bool JobSystem::pop(unsigned int index, std::function<void()>& job)
+{
+    Queue& queue = *mQueues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.jobs.empty())
+        return false;
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(unsigned int thief, std::function<void()>& job)
+{
+    for(size_t i = 1; i <= mQueues.size(); i++)
+    {
+        Queue& queue = *mQueues[(thief + i) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.jobs.empty())
+            continue;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne(int index)
+{
+    std::function<void()> job;
+    if(!pop(static_cast<unsigned int>(index), job) && !steal(static_cast<unsigned int>(index), job))
+        return false;
+    mQueued--;
+    job();
+    if(mOutsideWaiters > 0)
+    {
+        //the lock makes sure a waiter that just checked its counter is already waiting
+        {
+            std::lock_guard<std::mutex> lock(mDoneMutex);
+        }
+        mJobDone.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    tWorkerIndex = static_cast<int>(index);
+    while(true)
+    {
+        if(runOne(tWorkerIndex))
+            continue;
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mWakeUp.wait(lock, [this](){ return !bRunning || mQueued > 0; });
+        if(!bRunning && mQueued == 0)
+            return;
+    }
+}
+
+void JobSystem::wait(const std::atomic<size_t>& counter)
+{
+    if(tWorkerIndex >= 0)
+    {
+        while(counter > 0)
+        {
+            if(!runOne(tWorkerIndex))
+                std::this_thread::yield();
+        }
+        return;
+    }
+    mOutsideWaiters++;
+    {
+        std::unique_lock<std::mutex> lock(mDoneMutex);
+        mJobDone.wait(lock, [&counter](){ return counter == 0; });
+    }
+    mOutsideWaiters--;
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function, size_t grainSize)
+{
+    if(count == 0)
+        return;
+    if(grainSize == 0)
+        grainSize = std::max<size_t>(1, count / (mQueues.size() * 4));
+    const size_t chunks = (count + grainSize - 1) / grainSize;
+    if(chunks == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    //Chunks are claimed from a shared index by the caller and a few helper jobs alike, so whoever is
+    //free does the next one. A helper that starts after the loop is done finds nothing to claim
+    //and never touches function, which is why the state outlives this call
+    struct Loop
+    {
+        std::atomic<size_t> next {0};
+        std::atomic<size_t> remaining {0};
+    };
+    auto loop = std::make_shared<Loop>();
+    auto runChunks = [loop, &function, count, grainSize, chunks]()
+    {
+        for(size_t chunk = loop->next++; chunk < chunks; chunk = loop->next++)
+        {
+            size_t begin = chunk * grainSize;
+            function(begin, std::min(count, begin + grainSize));
+            loop->remaining--;
+        }
+    };
+    loop->remaining = chunks;
+    const size_t helpers = std::min<size_t>(chunks - 1, mQueues.size());
+    for(size_t i = 0; i < helpers; i++)
+        schedule(runChunks);
+    runChunks();
+    //every chunk is claimed, wait for the ones still running on a worker. Helpers stuck in a queue
+    //behind a long job are not waited for, they have nothing left to do
+    wait(loop->remaining);
+}
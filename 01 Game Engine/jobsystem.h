@@ -0,0 +1,76 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <atomic>
+
+//Engine wide pool of worker threads.
+//Anything that does not have to run on the GUI thread (file parsing, decoding, cooking,
+//PhysX tasks through JobDispatcher) gets pushed in here as a job.
+//Every worker has its own deque. A worker takes the newest job from its own deque and when
+//that is empty steals the oldest job from another worker, so one long job can't hold up the rest.
+class JobSystem
+{
+public:
+    static JobSystem* getInstance();
+
+    void schedule(std::function<void()> job);
+
+    //Schedules a job and gives back a future for its return value
+    template<typename F>
+    auto submit(F&& function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        std::future<Result> result = task->get_future();
+        schedule([task](){ (*task)(); });
+        return result;
+    }
+
+    //Splits [0, count) into chunks of grainSize and runs function(begin, end) on them in parallel.
+    //The calling thread runs chunks too and returns when all of them are done. It only ever runs
+    //chunks of its own loop, so the GUI thread can't get stuck in somebody's long cooking job.
+    //grainSize 0 picks a size that gives every worker a few chunks.
+    void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function, size_t grainSize = 0);
+
+    //Waits for counter to reach 0. A worker runs other jobs meanwhile instead of blocking its thread,
+    //a thread outside the pool (GUI) just sleeps until a job finishes, it never picks up other jobs
+    void wait(const std::atomic<size_t>& counter);
+
+    unsigned int workerCount() const {return static_cast<unsigned int>(mWorkers.size());}
+
+private:
+    JobSystem();
+    ~JobSystem();
+    void workerLoop(unsigned int index);
+    bool runOne(int index);
+    bool pop(unsigned int index, std::function<void()>& job);
+    bool steal(unsigned int thief, std::function<void()>& job);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::thread> mWorkers;
+    std::vector<std::unique_ptr<Queue>> mQueues;    //one pr worker
+    std::atomic<unsigned int> mNextQueue {0};       //round robin for jobs from outside the pool
+    std::atomic<size_t> mQueued {0};
+    std::mutex mSleepMutex;
+    std::condition_variable mWakeUp;
+    //threads outside the pool sleeping in wait(), woken whenever a job finishes
+    std::mutex mDoneMutex;
+    std::condition_variable mJobDone;
+    std::atomic<unsigned int> mOutsideWaiters {0};
+    std::atomic<bool> bRunning {true};
+};
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,33 @@
+#ifndef OPENALCHECK_H
+#define OPENALCHECK_H
+
+#include <iostream>
+#include "AL/al.h"
+
+//Taken from https://youtu.be/WvND0djMcfE and https://github.com/mattstone22133/OpenAL_TestProject
+//OpenAL error checking. alGetError() syncs with the audio driver, so release builds leave it out
+#if defined(QT_NO_DEBUG) || defined(NDEBUG)
+
+#define OpenAL_ErrorCheck(message)
+
+#define alec(FUNCTION_CALL)\
+FUNCTION_CALL
+
+#else
+
+#define OpenAL_ErrorCheck(message)\
+{\
+    ALenum error = alGetError();\
+    if(error != AL_NO_ERROR)\
+    {\
+        std::cerr << "OpenAL Error: " << error << " with call for " << #message << std::endl;\
+    }\
+}
+
+#define alec(FUNCTION_CALL)\
+FUNCTION_CALL;\
+OpenAL_ErrorCheck(FUNCTION_CALL)
+
+#endif
+
+#endif // OPENALCHECK_H
@@ -0,0 +1,21 @@
+-- Physics world settings, read by PhysicsConfig::fromLua before init.lua runs.
+-- Physics.Preset picks one of the Presets, anything else in Physics overrides it.
+Presets = {}
+Presets.Default = { Broadphase = "SAP", Solver = "PGS", Friction = "Patch", PCM = true }
+Presets.OpenWorld = {
+    Broadphase = "MBP",
+    WorldBounds = { Min = { -512, -512, -128 }, Max = { 512, 512, 256 } },
+    MbpSubdivisions = 4,
+    ActiveActors = true,
+    PCM = true
+}
+Presets.Stacking = { Broadphase = "ABP", Solver = "TGS", Friction = "Patch", PCM = true }
+Presets.FastObjects = { Broadphase = "ABP", Solver = "PGS", CCD = true, PCM = true }
+
+Physics = {
+    Preset = "Default",
+    DebugDraw = false,
+    -- snapshots for F6 / physicsbenchmark --replay, 0 is off
+    RecordInterval = 0,
+    EnhancedDeterminism = false
+}
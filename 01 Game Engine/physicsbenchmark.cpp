@@ -0,0 +1,473 @@
+#include "physicsbenchmark.h"
+#include "jobsystem.h"
+#include "cookingservice.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <thread>
+
+namespace
+{
+void addGround(PhysicsComponent& physics)
+{
+    PxRigidStatic* ground = PxCreatePlane(*physics.getPhysics(), PxPlane(0,0,1,0), *physics.registry().material(0.5f, 0.5f, 0.5f));
+    physics.getScene()->addActor(*ground);
+}
+
+//The main scene's dynamics, plus the ones in the region grid when it is on
+std::vector<PxRigidDynamic*> dynamics(PhysicsComponent& physics)
+{
+    PxScene* scene = physics.getScene();
+    std::vector<PxActor*> actors(scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+    scene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, actors.data(), static_cast<PxU32>(actors.size()));
+    std::vector<PxRigidDynamic*> bodies;
+    for(PxActor* actor : actors)
+        bodies.push_back(static_cast<PxRigidDynamic*>(actor));
+    if(physics.regions().enabled())
+    {
+        for(PxRigidActor* actor : physics.mRigidBodies)
+            bodies.push_back(static_cast<PxRigidDynamic*>(actor));
+    }
+    return bodies;
+}
+
+void setSolverIterations(PhysicsComponent& physics, PxU32 positionIterations)
+{
+    for(PxRigidDynamic* body : dynamics(physics))
+        body->setSolverIterationCounts(positionIterations, 1);
+}
+
+//A random rock shaped point cloud, cooked through the same path as the game objects
+std::vector<Vertex> rockPoints(std::mt19937& random, PxReal radius)
+{
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::vector<Vertex> points;
+    for(int i = 0; i < 24; i++)
+    {
+        QVector3D direction(unit(random), unit(random), unit(random));
+        direction.normalize();
+        points.push_back(Vertex(direction * radius * (0.7f + 0.3f * std::abs(unit(random))), direction, QVector2D(0,0)));
+    }
+    return points;
+}
+}
+
+std::vector<PhysicsBenchmark::Scene> PhysicsBenchmark::defaultScenes()
+{
+    return {
+        {"pyramid", 40, &PhysicsBenchmark::buildPyramid},
+        {"convexpile", 2000, &PhysicsBenchmark::buildConvexPile},
+        {"chains", 100, &PhysicsBenchmark::buildChains},
+        {"terrain", 3000, &PhysicsBenchmark::buildTerrainScatter},
+        {"regions", 8000, &PhysicsBenchmark::buildRegions, 32.f},
+    };
+}
+
+//size x size box pyramid, like helloWorldSnippets() but bigger
+void PhysicsBenchmark::buildPyramid(PhysicsComponent& physics, PxU32 size)
+{
+    addGround(physics);
+    const PxReal halfExtent = 0.5f;
+    PxShape* shape = physics.registry().shape(PxBoxGeometry(halfExtent, halfExtent, halfExtent), physics.registry().material(0.5f, 0.5f, 0.5f));
+    for(PxU32 i = 0; i < size; i++)
+    {
+        for(PxU32 j = 0; j < size - i; j++)
+        {
+            PxVec3 position(PxReal(j * 2) - PxReal(size - i), 0.f, PxReal(i * 2 + 1));
+            PxRigidDynamic* body = physics.newDynamic(PxTransform(position * halfExtent));
+            body->attachShape(*shape);
+            PxRigidBodyExt::updateMassAndInertia(*body, 10.f);
+            physics.getScene()->addActor(*body);
+        }
+    }
+}
+
+//Many convex hulls dropped into a heap, a handful of unique hulls shared between them
+void PhysicsBenchmark::buildConvexPile(PhysicsComponent& physics, PxU32 count)
+{
+    addGround(physics);
+    std::mt19937 random(1234);
+    std::vector<PxConvexMesh*> hulls;
+    for(int i = 0; i < 8; i++)
+    {
+        std::vector<Vertex> points = rockPoints(random, 0.5f);
+        hulls.push_back(physics.cookConvexMesh(points, std::vector<GLuint>()));
+    }
+    PxU32 side = static_cast<PxU32>(std::ceil(std::sqrt(count / 10.f)));
+    for(PxU32 i = 0; i < count; i++)
+    {
+        PxU32 layer = i / (side * side);
+        PxU32 x = i % side;
+        PxU32 y = (i / side) % side;
+        PxVec3 position(x * 1.2f - side * 0.6f, y * 1.2f - side * 0.6f, 1.f + layer * 1.2f);
+        PxConvexMesh* hull = hulls[i % hulls.size()];
+        physics.registry().retain(hull);    //addDynamic takes over one reference
+        physics.addDynamic(hull, "rock", PxTransform(position));
+    }
+    for(PxConvexMesh* hull : hulls)
+        physics.registry().release(hull);
+}
+
+//Ragdoll-ish chains: capsules hanging off a static anchor, linked with spherical joints
+void PhysicsBenchmark::buildChains(PhysicsComponent& physics, PxU32 count)
+{
+    addGround(physics);
+    const PxU32 links = 12;
+    const PxReal radius = 0.15f, halfHeight = 0.3f;
+    PxMaterial* material = physics.registry().material(0.5f, 0.5f, 0.5f);
+    PxShape* shape = physics.registry().shape(PxCapsuleGeometry(radius, halfHeight), material);
+    PxU32 side = static_cast<PxU32>(std::ceil(std::sqrt(PxReal(count))));
+    for(PxU32 chain = 0; chain < count; chain++)
+    {
+        PxVec3 top((chain % side) * 2.f, (chain / side) * 2.f, links * 2.f * halfHeight + 2.f);
+        PxRigidStatic* anchor = physics.getPhysics()->createRigidStatic(PxTransform(top));
+        physics.getScene()->addActor(*anchor);
+        PxRigidActor* previous = anchor;
+        PxTransform previousFrame(PxIdentity);
+        for(PxU32 link = 0; link < links; link++)
+        {
+            //capsules lie along X, the chain starts out horizontal and swings down
+            PxVec3 position = top + PxVec3((link * 2 + 1) * (halfHeight + radius), 0.f, 0.f);
+            PxRigidDynamic* body = physics.newDynamic(PxTransform(position));
+            body->attachShape(*shape);
+            PxRigidBodyExt::updateMassAndInertia(*body, 1.f);
+            physics.getScene()->addActor(*body);
+            PxSphericalJointCreate(*physics.getPhysics(), previous, previousFrame,
+                                   body, PxTransform(PxVec3(-(halfHeight + radius), 0.f, 0.f)));
+            previous = body;
+            previousFrame = PxTransform(PxVec3(halfHeight + radius, 0.f, 0.f));
+        }
+    }
+}
+
+//Spheres and hulls rolling over a height field terrain
+void PhysicsBenchmark::buildTerrainScatter(PhysicsComponent& physics, PxU32 count)
+{
+    HeightGrid grid;
+    grid.rows = grid.columns = 128;
+    grid.rowScale = grid.columnScale = 1.f;
+    grid.origin = PxVec3(-64.f, -64.f, 0.f);
+    grid.heights.resize(grid.rows * grid.columns);
+    for(PxU32 row = 0; row < grid.rows; row++)
+        for(PxU32 column = 0; column < grid.columns; column++)
+            grid.heights[row * grid.columns + column] = 3.f * std::sin(row * 0.1f) * std::cos(column * 0.13f);
+    physics.addTerrain(physics.cookHeightField(grid), "Terrain");
+
+    std::mt19937 random(4321);
+    std::uniform_real_distribution<float> spread(-60.f, 60.f);
+    PxShape* sphere = physics.registry().shape(PxSphereGeometry(0.5f), physics.registry().material(0.5f, 0.5f, 0.5f));
+    PxConvexMesh* hull = physics.cookConvexMesh(rockPoints(random, 0.5f), std::vector<GLuint>());
+    for(PxU32 i = 0; i < count; i++)
+    {
+        PxTransform pose(PxVec3(spread(random), spread(random), 5.f + (i % 10)));
+        if(i % 2)
+        {
+            physics.registry().retain(hull);
+            physics.addDynamic(hull, "rock", pose);
+            continue;
+        }
+        PxRigidDynamic* body = physics.newDynamic(pose);
+        body->attachShape(*sphere);
+        PxRigidBodyExt::updateMassAndInertia(*body, 1.f);
+        physics.getScene()->addActor(*body);
+    }
+    physics.registry().release(hull);
+}
+
+//A 512x512 world on the region grid: one ground box under all of it, a boulder in every region
+//and hulls spread over the whole world. Only the regions around the origin load and simulate,
+//the rest of the bodies wait parked
+void PhysicsBenchmark::buildRegions(PhysicsComponent& physics, PxU32 count)
+{
+    const PxReal halfWorld = 256.f;
+    PxMaterial* material = physics.registry().material(0.5f, 0.5f, 0.5f);
+    std::vector<PxRigidActor*> statics;
+    PxShape* ground = physics.registry().shape(PxBoxGeometry(halfWorld, halfWorld, 1.f), material);
+    PxShape* boulder = physics.registry().shape(PxBoxGeometry(2.f, 2.f, 2.f), material);
+    if(!ground || !boulder)
+        return;
+    PxRigidStatic* actor = physics.getPhysics()->createRigidStatic(PxTransform(PxVec3(0.f, 0.f, -1.f)));
+    actor->attachShape(*ground);
+    statics.push_back(actor);
+    const PxReal regionSize = physics.config().regionSize;
+    for(PxReal x = -halfWorld; x < halfWorld; x += regionSize)
+    {
+        for(PxReal y = -halfWorld; y < halfWorld; y += regionSize)
+        {
+            actor = physics.getPhysics()->createRigidStatic(PxTransform(PxVec3(x + regionSize * 0.5f, y + regionSize * 0.5f, 2.f)));
+            actor->attachShape(*boulder);
+            statics.push_back(actor);
+        }
+    }
+    physics.addActors(statics);
+
+    std::mt19937 random(777);
+    std::uniform_real_distribution<float> spread(-halfWorld + 1.f, halfWorld - 1.f);
+    PxConvexMesh* hull = physics.cookConvexMesh(rockPoints(random, 0.5f), std::vector<GLuint>());
+    for(PxU32 i = 0; i < count; i++)
+    {
+        physics.registry().retain(hull);    //addDynamic takes over one reference
+        physics.addDynamic(hull, "rock", PxTransform(PxVec3(spread(random), spread(random), 5.f + (i % 10))));
+    }
+    physics.registry().release(hull);
+}
+
+std::vector<PhysicsBenchmark::Result> PhysicsBenchmark::run(const Settings& settings)
+{
+    std::vector<int> threadCounts = settings.threadCounts;
+    if(threadCounts.empty())
+    {
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for(int threads = 1; threads < cores; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(cores);
+    }
+
+    std::vector<Result> results;
+    for(const Scene& scene : defaultScenes())
+    {
+        if(!settings.scenes.empty() &&
+           std::find(settings.scenes.begin(), settings.scenes.end(), scene.name) == settings.scenes.end())
+            continue;
+
+        for(PxU32 iterations : settings.positionIterations)
+        {
+            if(!settings.presets.empty())
+            {
+                for(const auto& preset : settings.presets)
+                {
+                    results.push_back(runOne(scene, settings, preset.second, iterations));
+                    results.back().preset = preset.first;
+                }
+                continue;
+            }
+
+            size_t first = results.size();
+            for(int threads : threadCounts)
+            {
+                PhysicsConfig config = settings.config;
+                config.bUseJobSystem = false;
+                config.dispatcherThreads = threads;
+                results.push_back(runOne(scene, settings, config, iterations));
+            }
+            if(settings.bJobSystem)
+            {
+                PhysicsConfig config = settings.config;
+                config.bUseJobSystem = true;
+                results.push_back(runOne(scene, settings, config, iterations));
+            }
+            //scaling against the run with the fewest threads
+            const Result& base = results[first];
+            for(size_t i = first; i < results.size(); i++)
+            {
+                double speedup = base.meanMs / results[i].meanMs;
+                double extraThreads = double(std::max(results[i].threads, 1)) / std::max(base.threads, 1);
+                results[i].efficiency = speedup / extraThreads;
+            }
+        }
+    }
+    return results;
+}
+
+PhysicsBenchmark::Result PhysicsBenchmark::runOne(const Scene& scene, const Settings& settings, PhysicsConfig config, PxU32 positionIterations)
+{
+    //a fresh world for every run, so nothing carries over between them
+    if(scene.regionSize > 0.f)
+        config.regionSize = scene.regionSize;
+    PhysicsComponent physics;
+    physics.initPhysics(config);
+    scene.build(physics, scene.size);
+    setSolverIterations(physics, positionIterations);
+
+    Result result = measure(physics, settings);
+    result.scene = scene.name;
+    result.dispatcher = config.bUseJobSystem ? "jobs" : "default";
+    result.threads = config.bUseJobSystem ? static_cast<int>(JobSystem::getInstance()->workerCount()) : config.dispatcherThreads;
+    result.positionIterations = positionIterations;
+    return result;
+}
+
+PhysicsBenchmark::Result PhysicsBenchmark::measure(PhysicsComponent& physics, const Settings& settings)
+{
+    for(PxU32 i = 0; i < settings.warmupSteps; i++)
+        physics.simulationStep(settings.dt);
+
+    std::vector<double> times;
+    times.reserve(settings.steps);
+    for(PxU32 i = 0; i < settings.steps; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        physics.simulationStep(settings.dt);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    Result result;
+    result.bodies = static_cast<PxU32>(dynamics(physics).size());
+    if(times.empty())
+        return result;
+    for(double time : times)
+        result.meanMs += time;
+    result.meanMs /= times.size();
+    std::sort(times.begin(), times.end());
+    result.minMs = times.front();
+    result.p95Ms = times[std::min(times.size() - 1, times.size() * 95 / 100)];
+    return result;
+}
+
+bool PhysicsBenchmark::runReplay(const std::string& fileName, const Settings& settings, Result& result)
+{
+    PhysicsComponent physics;
+    physics.initPhysics(settings.config);
+    if(!physics.importScene(fileName))
+        return false;
+    setSolverIterations(physics, settings.positionIterations.empty() ? 4 : settings.positionIterations.front());
+
+    //The game saves the state a few steps before the slow one (F6), the count is next to the file.
+    //Those steps run as warmup, so the first measured step is the slow one
+    Settings replaySettings = settings;
+    replaySettings.warmupSteps = 0;
+    std::ifstream steps(fileName + ".steps");
+    steps >> replaySettings.warmupSteps;
+    result = measure(physics, replaySettings);
+    result.scene = fileName;
+    result.dispatcher = settings.config.bUseJobSystem ? "jobs" : "default";
+    result.threads = settings.config.bUseJobSystem ? static_cast<int>(JobSystem::getInstance()->workerCount()) : settings.config.dispatcherThreads;
+    result.positionIterations = settings.positionIterations.empty() ? 4 : settings.positionIterations.front();
+    return true;
+}
+
+PhysicsBenchmark::QueryResult PhysicsBenchmark::runQueries(PxU32 queries, const Settings& settings)
+{
+    PhysicsComponent physics;
+    physics.initPhysics(settings.config);
+    buildTerrainScatter(physics, 1000);
+    for(PxU32 i = 0; i < settings.warmupSteps; i++)
+        physics.simulationStep(settings.dt);
+
+    //half ground checks straight down, half line of sight between two random points
+    std::mt19937 random(99);
+    std::uniform_real_distribution<float> spread(-60.f, 60.f);
+    std::vector<PxVec3> origins(queries), directions(queries);
+    std::vector<PxReal> distances(queries);
+    for(PxU32 i = 0; i < queries; i++)
+    {
+        origins[i] = PxVec3(spread(random), spread(random), 20.f);
+        PxVec3 target = i % 2 ? PxVec3(spread(random), spread(random), 2.f) : PxVec3(origins[i].x, origins[i].y, -10.f);
+        directions[i] = target - origins[i];
+        distances[i] = directions[i].normalize();
+    }
+
+    QueryResult result;
+    result.queries = queries;
+    PxScene* scene = physics.getScene();
+    const PxU32 rounds = std::max<PxU32>(1, settings.steps / 10);
+    for(PxU32 round = 0; round < rounds; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(PxU32 i = 0; i < queries; i++)
+        {
+            PxRaycastBuffer buffer;
+            scene->raycast(origins[i], directions[i], distances[i], buffer);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        SceneQueryBatch& batch = physics.queries();
+        for(PxU32 i = 0; i < queries; i++)
+            batch.raycast(origins[i], directions[i], distances[i]);
+        batch.execute();
+        auto end = std::chrono::steady_clock::now();
+
+        result.singleMs += std::chrono::duration<double, std::milli>(middle - start).count();
+        result.batchMs += std::chrono::duration<double, std::milli>(end - middle).count();
+    }
+    result.singleMs /= rounds;
+    result.batchMs /= rounds;
+    return result;
+}
+
+PhysicsBenchmark::CookingResult PhysicsBenchmark::runCooking(PxU32 meshes, const Settings& settings)
+{
+    PhysicsConfig config = settings.config;
+    config.cookingCacheDirectory.clear();
+    config.proxyTolerance = 0.f;    //always a hull, fitting primitives would skip the cooking
+    PhysicsComponent physics;
+    physics.initPhysics(config);
+
+    //Twice as many meshes as asked for, half for each run, so the registry can't share any between them
+    std::mt19937 random(2024);
+    std::vector<std::vector<Vertex>> points;
+    for(PxU32 i = 0; i < meshes * 2; i++)
+        points.push_back(rockPoints(random, 0.5f + 0.001f * i));
+    const std::vector<GLuint> noIndices;
+
+    CookingResult result;
+    result.meshes = meshes;
+    auto start = std::chrono::steady_clock::now();
+    for(PxU32 i = 0; i < meshes; i++)
+    {
+        CollisionProxy proxy = physics.buildProxy(points[i], noIndices);
+        physics.addDynamic(proxy, "serial", PxTransform(PxVec3(PxReal(i % 32) * 2.f, PxReal(i / 32) * 2.f, 5.f)));
+    }
+    result.serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<CookingService::Request> requests(meshes);
+    for(PxU32 i = 0; i < meshes; i++)
+    {
+        requests[i].name = "batch";
+        requests[i].vertices = &points[meshes + i];
+        requests[i].indices = &noIndices;
+        requests[i].pose = PxTransform(PxVec3(PxReal(i % 32) * 2.f, PxReal(i / 32) * 2.f, 10.f));
+    }
+    CookingService service(physics);
+    start = std::chrono::steady_clock::now();
+    std::vector<CookingService::Result> cooked = service.cook(requests);
+    service.insert(cooked);
+    result.batchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.batchCookMs = CookingService::totalCookMs(cooked);
+    for(const CookingService::Result& mesh : cooked)
+        result.slowestMeshMs = std::max(result.slowestMeshMs, mesh.cookMs);
+    return result;
+}
+
+void PhysicsBenchmark::print(const CookingResult& result, std::ostream& out)
+{
+    out << std::fixed << std::setprecision(3)
+        << result.meshes << " meshes: serial " << result.serialMs << " ms, batch " << result.batchMs
+        << " ms (" << (result.batchMs > 0.0 ? result.serialMs / result.batchMs : 0.0) << "x), "
+        << "cook time in batch " << result.batchCookMs << " ms, slowest mesh " << result.slowestMeshMs << " ms\n";
+}
+
+void PhysicsBenchmark::print(const QueryResult& result, std::ostream& out)
+{
+    out << std::fixed << std::setprecision(3)
+        << result.queries << " raycasts: one by one " << result.singleMs << " ms, batched " << result.batchMs
+        << " ms (" << (result.batchMs > 0.0 ? result.singleMs / result.batchMs : 0.0) << "x)\n";
+}
+
+void PhysicsBenchmark::print(const std::vector<Result>& results, std::ostream& out)
+{
+    out << std::left << std::setw(12) << "scene" << std::setw(12) << "preset" << std::right
+        << std::setw(10) << "dispatcher" << std::setw(8) << "threads" << std::setw(8) << "iters" << std::setw(8) << "bodies"
+        << std::setw(12) << "mean ms" << std::setw(12) << "min ms" << std::setw(12) << "p95 ms"
+        << std::setw(12) << "efficiency" << "\n";
+    out << std::fixed << std::setprecision(3);
+    for(const Result& result : results)
+    {
+        out << std::left << std::setw(12) << result.scene << std::setw(12) << result.preset << std::right
+            << std::setw(10) << result.dispatcher << std::setw(8) << result.threads << std::setw(8) << result.positionIterations << std::setw(8) << result.bodies
+            << std::setw(12) << result.meanMs << std::setw(12) << result.minMs << std::setw(12) << result.p95Ms
+            << std::setw(12) << result.efficiency << "\n";
+    }
+}
+
+void PhysicsBenchmark::writeCsv(const std::vector<Result>& results, std::ostream& out)
+{
+    out << "scene,preset,dispatcher,threads,position_iterations,bodies,mean_ms,min_ms,p95_ms,efficiency\n";
+    for(const Result& result : results)
+    {
+        out << result.scene << "," << result.preset << "," << result.dispatcher << "," << result.threads << "," << result.positionIterations << "," << result.bodies << ","
+            << result.meanMs << "," << result.minMs << "," << result.p95Ms << "," << result.efficiency << "\n";
+    }
+}
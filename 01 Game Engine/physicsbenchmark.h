@@ -0,0 +1,100 @@
+#ifndef PHYSICSBENCHMARK_H
+#define PHYSICSBENCHMARK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "physicsmanager.h"
+
+//Stress scenes for PhysicsComponent, run for a fixed number of steps under different
+//dispatcher thread counts and solver settings. Gives simulate time pr step and how well it
+//scales with threads, so the thread count can be picked from data instead of "half the cores".
+//Runs without a window, see benchmarkmain.cpp.
+class PhysicsBenchmark
+{
+public:
+    struct Scene
+    {
+        std::string name;
+        PxU32 size;     //meaning depends on the scene, roughly how many bodies it makes
+        std::function<void(PhysicsComponent& physics, PxU32 size)> build;
+        float regionSize {0.f};     //runs on the region grid with this size, 0 uses the config's
+    };
+
+    struct Settings
+    {
+        PxU32 warmupSteps {60};
+        PxU32 steps {600};
+        float dt {1.f / 60.f};
+        std::vector<int> threadCounts;              //PxDefaultCpuDispatcher threads, empty is 1, 2, 4 ... up to all cores
+        bool bJobSystem {true};                     //also run on the engine JobSystem (JobDispatcher)
+        std::vector<PxU32> positionIterations {4};
+        std::vector<std::string> scenes;            //empty runs all of them
+        PhysicsConfig config;                       //used for everything not swept
+        //When set, every scene runs once pr preset instead of sweeping threads
+        std::vector<std::pair<std::string, PhysicsConfig>> presets;
+    };
+
+    struct Result
+    {
+        std::string scene;
+        std::string preset;         //empty when sweeping threads
+        std::string dispatcher;     //"default" or "jobs"
+        int threads {0};
+        PxU32 positionIterations {0};
+        PxU32 bodies {0};
+        double meanMs {0.0};
+        double minMs {0.0};
+        double p95Ms {0.0};
+        double efficiency {0.0};    //speedup over the fewest threads, divided by the extra threads
+    };
+
+    //Ground checks and line of sight rays over the terrain scene, one at a time against the
+    //PxScene compared to the same rays through SceneQueryBatch
+    struct QueryResult
+    {
+        PxU32 queries {0};
+        double singleMs {0.0};
+        double batchMs {0.0};
+    };
+
+    //Unique meshes cooked one after another on this thread compared to a CookingService batch.
+    //The disk cache is turned off so every mesh really is cooked
+    struct CookingResult
+    {
+        PxU32 meshes {0};
+        double serialMs {0.0};
+        double batchMs {0.0};
+        double batchCookMs {0.0};   //sum of the pr mesh times inside the batch
+        double slowestMeshMs {0.0};
+    };
+
+    static std::vector<Scene> defaultScenes();
+    std::vector<Result> run(const Settings& settings);
+
+    QueryResult runQueries(PxU32 queries, const Settings& settings);
+    CookingResult runCooking(PxU32 meshes, const Settings& settings);
+    //Steps a scene saved with PhysicsComponent::exportSnapshot() under settings.config. The only
+    //warmup is the steps in fileName.steps (written by the game next to the snapshot), so the
+    //first measured step is the one that was slow in the game
+    bool runReplay(const std::string& fileName, const Settings& settings, Result& result);
+
+    static void print(const std::vector<Result>& results, std::ostream& out);
+    static void print(const QueryResult& result, std::ostream& out);
+    static void print(const CookingResult& result, std::ostream& out);
+    static void writeCsv(const std::vector<Result>& results, std::ostream& out);
+
+    //Scene builders
+    static void buildPyramid(PhysicsComponent& physics, PxU32 size);
+    static void buildConvexPile(PhysicsComponent& physics, PxU32 count);
+    static void buildChains(PhysicsComponent& physics, PxU32 count);
+    static void buildTerrainScatter(PhysicsComponent& physics, PxU32 count);
+    static void buildRegions(PhysicsComponent& physics, PxU32 count);
+
+private:
+    Result runOne(const Scene& scene, const Settings& settings, PhysicsConfig config, PxU32 positionIterations);
+    Result measure(PhysicsComponent& physics, const Settings& settings);
+};
+
+#endif // PHYSICSBENCHMARK_H
@@ -0,0 +1,220 @@
+#include "physicsconfig.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+extern "C"
+{
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+namespace
+{
+//Small helpers for reading the table on top of the stack, a missing field leaves the value alone
+void readBool(lua_State* L, const char* field, bool& value)
+{
+    lua_getfield(L, -1, field);
+    if(lua_isboolean(L, -1))
+        value = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1);
+}
+
+//A number that doesn't fit in T (a negative count, say) would wrap around, so it is left alone
+template<typename T>
+void readNumber(lua_State* L, const char* field, T& value)
+{
+    lua_getfield(L, -1, field);
+    if(lua_isnumber(L, -1))
+    {
+        const lua_Number number = lua_tonumber(L, -1);
+        if(number >= static_cast<lua_Number>(std::numeric_limits<T>::lowest()) &&
+           number <= static_cast<lua_Number>(std::numeric_limits<T>::max()))
+            value = static_cast<T>(number);
+        else
+            std::cerr << "physics.lua: " << field << " = " << number << " is out of range\n";
+    }
+    lua_pop(L, 1);
+}
+
+void readString(lua_State* L, const char* field, std::string& value)
+{
+    lua_getfield(L, -1, field);
+    if(lua_isstring(L, -1))
+        value = lua_tostring(L, -1);
+    lua_pop(L, 1);
+}
+
+//Enums are written by name in Lua, e.g. Broadphase = "MBP"
+template<typename T>
+void readEnum(lua_State* L, const char* field, T& value, const std::vector<std::pair<const char*, T>>& names)
+{
+    std::string name;
+    readString(L, field, name);
+    if(name.empty())
+        return;
+    for(const auto& entry : names)
+    {
+        if(name == entry.first)
+        {
+            value = entry.second;
+            return;
+        }
+    }
+    std::cerr << "physics.lua: unknown " << field << " \"" << name << "\"\n";
+}
+
+//{x, y, z}
+void readVec3(lua_State* L, const char* field, physx::PxVec3& value)
+{
+    lua_getfield(L, -1, field);
+    if(lua_istable(L, -1))
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            lua_rawgeti(L, -1, i + 1);
+            if(lua_isnumber(L, -1))
+                value[i] = static_cast<float>(lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);
+}
+
+void readConfig(lua_State* L, PhysicsConfig& config)
+{
+    readBool(L, "UseJobSystem", config.bUseJobSystem);
+    readNumber(L, "DispatcherThreads", config.dispatcherThreads);
+    readNumber(L, "QueryCapacity", config.queryCapacity);
+    readNumber(L, "ContactEventCapacity", config.contactEventCapacity);
+    readNumber(L, "RecordInterval", config.recordInterval);
+    readNumber(L, "RecordCapacity", config.recordCapacity);
+    readNumber(L, "RegionSize", config.regionSize);
+    readNumber(L, "RegionLoadRadius", config.regionLoadRadius);
+    readNumber(L, "RegionBorder", config.regionBorder);
+    readNumber(L, "ActivityRadius", config.activityRadius);
+    readNumber(L, "ActivityHysteresis", config.activityHysteresis);
+    readEnum(L, "ActivityPolicy", config.activityPolicy, {{"Sleep", PhysicsConfig::ActivityPolicy::Sleep},
+                                                          {"Kinematic", PhysicsConfig::ActivityPolicy::Kinematic},
+                                                          {"Remove", PhysicsConfig::ActivityPolicy::Remove}});
+    readEnum(L, "Broadphase", config.broadphase, {{"SAP", PhysicsConfig::Broadphase::SAP},
+                                                  {"MBP", PhysicsConfig::Broadphase::MBP},
+                                                  {"ABP", PhysicsConfig::Broadphase::ABP}});
+    lua_getfield(L, -1, "WorldBounds");
+    if(lua_istable(L, -1))
+    {
+        readVec3(L, "Min", config.worldBounds.minimum);
+        readVec3(L, "Max", config.worldBounds.maximum);
+    }
+    lua_pop(L, 1);
+    readNumber(L, "MbpSubdivisions", config.mbpSubdivisions);
+    readEnum(L, "Solver", config.solver, {{"PGS", PhysicsConfig::Solver::PGS},
+                                          {"TGS", PhysicsConfig::Solver::TGS}});
+    readEnum(L, "Friction", config.friction, {{"Patch", PhysicsConfig::Friction::Patch},
+                                              {"OneDirectional", PhysicsConfig::Friction::OneDirectional},
+                                              {"TwoDirectional", PhysicsConfig::Friction::TwoDirectional}});
+    readBool(L, "ActiveActors", config.bActiveActors);
+    readBool(L, "PCM", config.bPCM);
+    readBool(L, "CCD", config.bCCD);
+    readBool(L, "EnhancedDeterminism", config.bEnhancedDeterminism);
+    readBool(L, "DebugDraw", config.bDebugDraw);
+    readEnum(L, "TerrainMode", config.terrainMode, {{"Auto", PhysicsConfig::TerrainMode::Auto},
+                                                    {"TriangleMesh", PhysicsConfig::TerrainMode::TriangleMesh},
+                                                    {"HeightField", PhysicsConfig::TerrainMode::HeightField}});
+    readNumber(L, "ProxyWeldDistance", config.proxyWeldDistance);
+    readNumber(L, "ProxyTolerance", config.proxyTolerance);
+    readNumber(L, "HullVertexLimit", config.hullVertexLimit);
+    readString(L, "CookingCacheDirectory", config.cookingCacheDirectory);
+}
+
+lua_State* openScript(const std::string& fileName)
+{
+    lua_State* L = luaL_newstate();
+    if(luaL_dofile(L, fileName.c_str()) != LUA_OK)
+    {
+        std::cerr << lua_tostring(L, -1) << "\n";
+        lua_close(L);
+        return nullptr;
+    }
+    return L;
+}
+}
+
+void PhysicsConfig::resolveConflicts()
+{
+    //the ActivityManager only sees the main scene, the dynamics are in the regions
+    if(regionSize > 0.f && activityRadius > 0.f)
+    {
+        std::cerr << "physics: ActivityRadius is ignored with RegionSize set\n";
+        activityRadius = 0.f;
+    }
+}
+
+std::string PhysicsConfig::buildKey() const
+{
+    return std::to_string(static_cast<int>(terrainMode)) + " " + std::to_string(bCCD) + " "
+         + std::to_string(hullVertexLimit) + " " + std::to_string(proxyWeldDistance) + " " + std::to_string(proxyTolerance);
+}
+
+bool PhysicsConfig::fromLua(const std::string& fileName, PhysicsConfig& config)
+{
+    //A state of its own, the config is read before the game script runs
+    lua_State* L = openScript(fileName);
+    if(!L)
+        return false;
+
+    lua_getglobal(L, "Physics");
+    if(!lua_istable(L, -1))
+    {
+        lua_close(L);
+        return false;
+    }
+    std::string preset;
+    readString(L, "Preset", preset);
+    if(!preset.empty())
+    {
+        lua_getglobal(L, "Presets");
+        if(lua_istable(L, -1))
+        {
+            lua_getfield(L, -1, preset.c_str());
+            if(lua_istable(L, -1))
+                readConfig(L, config);
+            else
+                std::cerr << fileName << ": no preset \"" << preset << "\"\n";
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+    readConfig(L, config);
+    lua_close(L);
+    return true;
+}
+
+bool PhysicsConfig::presetsFromLua(const std::string& fileName, const PhysicsConfig& base,
+                                   std::vector<std::pair<std::string, PhysicsConfig>>& presets)
+{
+    lua_State* L = openScript(fileName);
+    if(!L)
+        return false;
+
+    lua_getglobal(L, "Presets");
+    if(!lua_istable(L, -1))
+    {
+        lua_close(L);
+        return false;
+    }
+    lua_pushnil(L);
+    while(lua_next(L, -2))
+    {
+        if(lua_type(L, -2) == LUA_TSTRING && lua_istable(L, -1))
+        {
+            PhysicsConfig config = base;
+            readConfig(L, config);
+            presets.emplace_back(lua_tostring(L, -2), config);
+        }
+        lua_pop(L, 1);
+    }
+    lua_close(L);
+    return true;
+}
@@ -0,0 +1,128 @@
+#ifndef PHYSICSCONFIG_H
+#define PHYSICSCONFIG_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <foundation/PxBounds3.h>
+
+//Settings PhysicsComponent::initPhysics() builds the physics world from
+struct PhysicsConfig
+{
+    //Run PhysX tasks on the engine JobSystem, so physics and other jobs share one set of workers.
+    //Off gives PhysX its own PxDefaultCpuDispatcher with dispatcherThreads workers
+    bool bUseJobSystem {true};
+    //Worker threads for PxDefaultCpuDispatcher, -1 is half the cores.
+    //Run the physics benchmark to find what works best on a machine
+    int dispatcherThreads {-1};
+    //PxSceneDesc settings. Big open worlds want MBP with worldBounds around the playable area
+    enum class Broadphase
+    {
+        SAP,            //sweep and prune, good when few things move
+        MBP,            //multi box pruning, needs worldBounds
+        ABP             //automatic box pruning, MBP without the regions
+    };
+    Broadphase broadphase {Broadphase::SAP};
+    physx::PxBounds3 worldBounds {physx::PxVec3(-512.f, -512.f, -128.f), physx::PxVec3(512.f, 512.f, 256.f)};
+    unsigned int mbpSubdivisions {4};   //worldBounds is cut into subdivisions^2 regions along X and Y (1-16)
+
+    enum class Solver
+    {
+        PGS,            //projected Gauss-Seidel, the PhysX default
+        TGS             //temporal Gauss-Seidel, stiffer joints and stacks for the same iterations
+    };
+    Solver solver {Solver::PGS};
+
+    enum class Friction
+    {
+        Patch,
+        OneDirectional,
+        TwoDirectional
+    };
+    Friction friction {Friction::Patch};
+
+    bool bActiveActors {false};     //PxScene::getActiveActors() lists what moved last step
+    bool bPCM {true};               //persistent contact manifolds
+    bool bCCD {false};              //continuous collision for fast dynamics, every dynamic gets eENABLE_CCD
+    //Same results no matter what order actors were added in. Makes a PhysicsRecorder replay closer
+    //to the real thing, but not exact (see there). Costs a little solver time
+    bool bEnhancedDeterminism {false};
+
+    //Snapshot every dynamic every recordInterval steps and keep the last recordCapacity, see PhysicsRecorder. 0 is off
+    unsigned int recordInterval {0};
+    unsigned int recordCapacity {600};
+
+    //Dynamics further than activityRadius from the player are parked, see ActivityManager. 0 is off
+    float activityRadius {0.f};
+    float activityHysteresis {10.f};
+    enum class ActivityPolicy
+    {
+        Sleep,      //putToSleep(), cheapest to undo but anything touching it wakes it
+        Kinematic,  //frozen in place, still pushes other bodies away
+        Remove      //taken out of the scene, costs nothing at all while parked
+    };
+    ActivityPolicy activityPolicy {ActivityPolicy::Sleep};
+
+    //Splits the world into PxScenes of regionSize x regionSize that load around the player,
+    //see RegionGrid. 0 keeps everything in the one main scene. Turns off the ActivityManager,
+    //unloading far regions already does its job
+    float regionSize {0.f};
+    int regionLoadRadius {1};
+    float regionBorder {2.f};   //bodies this close to a neighbouring region get a ghost in it, see RegionGrid
+
+    //Contact/trigger events kept pr step, the rest are dropped (see ContactReporter)
+    unsigned int contactEventCapacity {1024};
+    //Raycasts pr step the SceneQueryBatch has room for up front, sweeps and overlaps get a quarter each
+    unsigned int queryCapacity {1024};
+
+    //PhysX Visual Debugger, off unless asked for since capturing costs simulation time
+    enum class PvdTransport
+    {
+        None,
+        Socket,     //live connection to a running PVD
+        File        //capture to a .pxd2 file that can be opened in PVD later
+    };
+    PvdTransport pvdTransport {PvdTransport::None};
+    std::string pvdHost {"127.0.0.1"};
+    int pvdPort {5425};
+    unsigned int pvdTimeoutMs {10};
+    std::string pvdFile {"physics.pxd2"};
+    bool bPvdTransmitContacts {false};
+    bool bPvdTransmitSceneQueries {false};
+
+    //Fill PxScene::getRenderBuffer() every step so PhysicsDebugRenderer can draw it
+    bool bDebugDraw {false};
+
+    //How terrain collision is built
+    enum class TerrainMode
+    {
+        Auto,           //height field when the terrain is a regular grid, else triangle mesh
+        TriangleMesh,
+        HeightField     //falls back to a triangle mesh (with a warning) if the terrain is not a grid
+    };
+    TerrainMode terrainMode {TerrainMode::Auto};
+
+    //Collision for dynamic meshes, see CollisionProxy
+    float proxyWeldDistance {0.001f};   //vertices closer than this are merged before fitting/cooking
+    float proxyTolerance {0.05f};       //how far a sphere/capsule/box may be from the mesh, relative to its size. 0 always cooks a hull
+    unsigned int hullVertexLimit {32};  //most vertices a cooked hull may have (4-255, under 8 uses plane shifting)
+
+    //Where cooked convex/triangle meshes are kept between runs, empty to always cook
+    std::string cookingCacheDirectory {"../GEA2022/cache"};
+
+    //Turns off what can't be used together, with a message. initPhysics() calls it
+    void resolveConflicts();
+    //The settings that end up in the actors themselves (terrain, CCD, proxies), as text for
+    //SceneSerializer::stamped(), so a level saved with other settings is cooked again
+    std::string buildKey() const;
+
+    //Reads the Physics table from a Lua file (physics.lua). If it names a Preset, the matching
+    //entry of the Presets table is applied first and the rest of Physics on top of it.
+    //Fields that are not in the file keep their value from config.
+    static bool fromLua(const std::string& fileName, PhysicsConfig& config);
+    //Every entry of the Presets table, each applied on top of base
+    static bool presetsFromLua(const std::string& fileName, const PhysicsConfig& base,
+                               std::vector<std::pair<std::string, PhysicsConfig>>& presets);
+};
+
+#endif // PHYSICSCONFIG_H
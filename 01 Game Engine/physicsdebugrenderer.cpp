@@ -0,0 +1,81 @@
+#include "physicsdebugrenderer.h"
+#include <QMatrix4x4>
+
+PhysicsDebugRenderer::PhysicsDebugRenderer()
+{
+
+}
+
+PhysicsDebugRenderer::~PhysicsDebugRenderer()
+{
+    if(mVAO == 0)
+        return;
+    glDeleteVertexArrays( 1, &mVAO );
+    glDeleteBuffers( 1, &mVBO );
+}
+
+void PhysicsDebugRenderer::init()
+{
+    initializeOpenGLFunctions();
+
+    glGenVertexArrays( 1, &mVAO );
+    glBindVertexArray( mVAO );
+
+    glGenBuffers( 1, &mVBO );
+    glBindBuffer( GL_ARRAY_BUFFER, mVBO );
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (GLvoid*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+}
+
+void PhysicsDebugRenderer::push(const PxVec3& position, PxU32 color)
+{
+    //PxDebugColor is 0xAARRGGBB
+    mVertices.push_back({position.x, position.y, position.z,
+                         ((color >> 16) & 0xff) / 255.f,
+                         ((color >> 8) & 0xff) / 255.f,
+                         (color & 0xff) / 255.f});
+}
+
+void PhysicsDebugRenderer::draw(const PxRenderBuffer& buffer, GLint matrixUniform)
+{
+    mVertices.clear();
+    mVertices.reserve(buffer.getNbLines() * 2 + buffer.getNbTriangles() * 6);
+
+    const PxDebugLine* lines = buffer.getLines();
+    for(PxU32 i = 0; i < buffer.getNbLines(); i++)
+    {
+        push(lines[i].pos0, lines[i].color0);
+        push(lines[i].pos1, lines[i].color1);
+    }
+    const PxDebugTriangle* triangles = buffer.getTriangles();
+    for(PxU32 i = 0; i < buffer.getNbTriangles(); i++)
+    {
+        const PxDebugTriangle& t = triangles[i];
+        push(t.pos0, t.color0); push(t.pos1, t.color1);
+        push(t.pos1, t.color1); push(t.pos2, t.color2);
+        push(t.pos2, t.color2); push(t.pos0, t.color0);
+    }
+    if(mVertices.empty())
+        return;
+
+    glBindVertexArray( mVAO );
+    glBindBuffer( GL_ARRAY_BUFFER, mVBO );
+    GLsizeiptr size = static_cast<GLsizeiptr>(mVertices.size() * sizeof(DebugVertex));
+    //Orphan the old storage every frame so we never wait for the GPU to finish with last frame's lines
+    if(size > mCapacity)
+        mCapacity = size + size / 2;
+    glBufferData( GL_ARRAY_BUFFER, mCapacity, nullptr, GL_STREAM_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, size, mVertices.data() );
+
+    //The render buffer is already in world space
+    QMatrix4x4 identity;
+    glUniformMatrix4fv( matrixUniform, 1, GL_FALSE, identity.constData() );
+    glDrawArrays( GL_LINES, 0, static_cast<GLsizei>(mVertices.size()) );
+    glBindVertexArray(0);
+}
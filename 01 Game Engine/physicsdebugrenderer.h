@@ -0,0 +1,36 @@
+#ifndef PHYSICSDEBUGRENDERER_H
+#define PHYSICSDEBUGRENDERER_H
+
+#include <QOpenGLFunctions_4_1_Core>
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Draws the lines and triangles PhysX puts in PxScene::getRenderBuffer().
+//Everything goes into one streamed VBO and is drawn with a single GL_LINES call,
+//triangles are drawn as their three edges.
+class PhysicsDebugRenderer : protected QOpenGLFunctions_4_1_Core
+{
+public:
+    PhysicsDebugRenderer();
+    ~PhysicsDebugRenderer();
+    void init();
+    //Expects the (plain) shader to be in use with view and projection matrix set
+    void draw(const PxRenderBuffer& buffer, GLint matrixUniform);
+
+private:
+    struct DebugVertex
+    {
+        GLfloat x, y, z;
+        GLfloat r, g, b;
+    };
+    void push(const PxVec3& position, PxU32 color);
+
+    std::vector<DebugVertex> mVertices;
+    GLuint mVAO{0};
+    GLuint mVBO{0};
+    GLsizeiptr mCapacity{0};   //size in bytes of the VBO on the GPU
+};
+
+#endif // PHYSICSDEBUGRENDERER_H
@@ -1,4 +1,42 @@
 ﻿#include "physicsmanager.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+//What the filter shader needs to know, copied into PhysX with the scene desc
+struct FilterShaderData
+{
+    bool bCCD;
+};
+
+//PxDefaultSimulationFilterShader, plus CCD contacts when the config asks for them and
+//contact reports for the pairs where a shape has ReportContacts (see ContactReporter)
+PxFilterFlags engineFilterShader(PxFilterObjectAttributes attributes0, PxFilterData filterData0,
+                                 PxFilterObjectAttributes attributes1, PxFilterData filterData1,
+                                 PxPairFlags& pairFlags, const void* constantBlock, PxU32 constantBlockSize)
+{
+    if(PxFilterObjectIsTrigger(attributes0) || PxFilterObjectIsTrigger(attributes1))
+    {
+        pairFlags = PxPairFlag::eTRIGGER_DEFAULT;
+        return PxFilterFlag::eDEFAULT;
+    }
+    pairFlags = PxPairFlag::eCONTACT_DEFAULT;
+    if((filterData0.word0 | filterData1.word0) & ReportContacts)
+        pairFlags |= PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_CONTACT_POINTS;
+    if(constantBlockSize == sizeof(FilterShaderData) && static_cast<const FilterShaderData*>(constantBlock)->bCCD)
+        pairFlags |= PxPairFlag::eDETECT_CCD_CONTACT;
+    return PxFilterFlag::eDEFAULT;
+}
+
+//PhysX only goes under 8 hull vertices with plane shifting, the default quickhull needs at least 8
+void setVertexLimit(PxConvexMeshDesc& description, unsigned int limit)
+{
+    description.vertexLimit = static_cast<PxU16>(PxClamp(limit, 4u, 255u));
+    if(description.vertexLimit < 8)
+        description.flags |= PxConvexFlag::ePLANE_SHIFTING;
+}
+}
 
 PhysicsComponent::PhysicsComponent()
 {
@@ -7,46 +45,83 @@ PhysicsComponent::PhysicsComponent()
 
 PhysicsComponent::~PhysicsComponent()
 {
- mPhysics->release();
- mCooking->release();
+ if(!mFoundation)   //initPhysics() never ran
+     return;
+ //Released in the opposite order of initPhysics(), so a new PhysicsComponent can be made afterwards
+ //(the benchmark makes one for every run)
+ mRegistry.release(mMaterial);
+ mSerializer.release();
+ mRegions.release();
+ if(mScene)
+     mScene->release();
+ if(mDispatcher)
+     mDispatcher->release();
+ if(mCooking)
+     mCooking->release();
+ if(mPhysics)
+     mPhysics->release();
+ if(mPvd)
+ {
+     PxPvdTransport* transport = mPvd->getTransport();
+     mPvd->release();
+     if(transport)
+         transport->release();
+ }
  mFoundation->release();
 }
 
-void PhysicsComponent::initPhysics()
+void PhysicsComponent::initPhysics(const PhysicsConfig& config)
 {
+    mConfig = config;
+    mConfig.resolveConflicts();
     try{
     mFoundation = PxCreateFoundation(PX_PHYSICS_VERSION, mAllocator, mErrorCallback);
 
-    mPvd = PxCreatePvd(*mFoundation);
-    PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate("127.0.0.1", 5425, 10);
-    mPvd->connect(*transport,PxPvdInstrumentationFlag::eALL);
+    //PVD is opt-in, see PhysicsConfig
+    PxPvdTransport* transport = nullptr;
+    if(mConfig.pvdTransport == PhysicsConfig::PvdTransport::Socket)
+        transport = PxDefaultPvdSocketTransportCreate(mConfig.pvdHost.c_str(), mConfig.pvdPort, mConfig.pvdTimeoutMs);
+    else if(mConfig.pvdTransport == PhysicsConfig::PvdTransport::File)
+        transport = PxDefaultPvdFileTransportCreate(mConfig.pvdFile.c_str());
+    if(transport)
+    {
+        mPvd = PxCreatePvd(*mFoundation);
+        mPvd->connect(*transport,PxPvdInstrumentationFlag::eALL);
+    }
 
 
     mToleranceScale.speed = 9.81f;
     mToleranceScale.length = 1.f;
 
 
-    mPhysics = PxCreatePhysics(PX_PHYSICS_VERSION, *mFoundation, mToleranceScale,true,mPvd);
-
-    PxSceneDesc sceneDesc(mPhysics->getTolerancesScale());
-    sceneDesc.gravity = PxVec3(0.0f, 0.0f, -9.81f);
-    mDispatcher = PxDefaultCpuDispatcherCreate(mThreads/2);
-    sceneDesc.cpuDispatcher	= mDispatcher;
-    sceneDesc.filterShader	= PxDefaultSimulationFilterShader;
-    mScene = mPhysics->createScene(sceneDesc);
-    PxPvdSceneClient* pvdClient = mScene->getScenePvdClient();
-    mScene->setVisualizationParameter(PxVisualizationParameter::eSCALE, 1.f);  //->setVisualizationParameter(PxVisualizationParameter::eSCALE, 1.0f);
+    //allocation tracking is only used by PVD's memory view
+    mPhysics = PxCreatePhysics(PX_PHYSICS_VERSION, *mFoundation, mToleranceScale,mPvd != nullptr,mPvd);
 
+    if(!mConfig.bUseJobSystem)
+        mDispatcher = PxDefaultCpuDispatcherCreate(mConfig.dispatcherThreads < 0 ? mThreads/2 : mConfig.dispatcherThreads);
+    mContacts.setup(mConfig.contactEventCapacity);
+    mScene = createScene(&mContacts, mConfig.worldBounds);
+    mQueries.setup(mScene, mConfig.queryCapacity, mConfig.queryCapacity / 4, mConfig.queryCapacity / 4);
+    mActivity.setup(mScene, mConfig.activityRadius, mConfig.activityHysteresis, mConfig.activityPolicy);
+    mRecorder.setup(mScene, mConfig.recordInterval, mConfig.recordCapacity);
+    mRegions.setup(this, mConfig.regionSize, mConfig.regionLoadRadius, mConfig.regionBorder,
+                   mConfig.worldBounds.minimum.z, mConfig.worldBounds.maximum.z);
 
+        PxPvdSceneClient* pvdClient = mScene->getScenePvdClient();
         if(pvdClient)
         {
             pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_CONSTRAINTS, true);
-            pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_CONTACTS, true);
-            pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_SCENEQUERIES, true);
+            pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_CONTACTS, mConfig.bPvdTransmitContacts);
+            pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_SCENEQUERIES, mConfig.bPvdTransmitSceneQueries);
         }
         mCooking = PxCreateCooking(PX_PHYSICS_VERSION, *mFoundation, PxCookingParams(mToleranceScale));
         if (!mCooking)
             std::cerr << "Error with cooking lib";
+        mCookingCache.setup(mPhysics, mCooking, mConfig.cookingCacheDirectory);
+        mRegistry.setup(mPhysics);
+        mSerializer.setup(mPhysics);
+        //default material, shared by everything that does not ask for another one
+        mMaterial = mRegistry.material(0.5f, 0.5f, 0.5f);
 
      //mLogger->logText("Physx Init" + PxS,LogType::LOG);
 
@@ -56,134 +131,554 @@ void PhysicsComponent::initPhysics()
     }
 }
 
+//Every scene gets the same settings from the config and shares the dispatcher,
+//so region scenes (see RegionGrid) run on the same threads as the main one
+PxScene* PhysicsComponent::createScene(PxSimulationEventCallback* callback, const PxBounds3& bounds)
+{
+    PxSceneDesc sceneDesc(mPhysics->getTolerancesScale());
+    sceneDesc.gravity = PxVec3(0.0f, 0.0f, -9.81f);
+    if(mDispatcher)
+        sceneDesc.cpuDispatcher = mDispatcher;
+    else
+        sceneDesc.cpuDispatcher = &mJobDispatcher;
+    FilterShaderData filterData {mConfig.bCCD};
+    sceneDesc.filterShader = engineFilterShader;
+    sceneDesc.filterShaderData = &filterData;
+    sceneDesc.filterShaderDataSize = sizeof(filterData);
+    sceneDesc.simulationEventCallback = callback;
+
+    switch(mConfig.broadphase)
+    {
+    case PhysicsConfig::Broadphase::SAP: sceneDesc.broadPhaseType = PxBroadPhaseType::eSAP; break;
+    case PhysicsConfig::Broadphase::MBP: sceneDesc.broadPhaseType = PxBroadPhaseType::eMBP; break;
+    case PhysicsConfig::Broadphase::ABP: sceneDesc.broadPhaseType = PxBroadPhaseType::eABP; break;
+    }
+    sceneDesc.solverType = mConfig.solver == PhysicsConfig::Solver::TGS ? PxSolverType::eTGS : PxSolverType::ePGS;
+    switch(mConfig.friction)
+    {
+    case PhysicsConfig::Friction::Patch: sceneDesc.frictionType = PxFrictionType::ePATCH; break;
+    case PhysicsConfig::Friction::OneDirectional: sceneDesc.frictionType = PxFrictionType::eONE_DIRECTIONAL; break;
+    case PhysicsConfig::Friction::TwoDirectional: sceneDesc.frictionType = PxFrictionType::eTWO_DIRECTIONAL; break;
+    }
+    auto setSceneFlag = [&sceneDesc](PxSceneFlag::Enum flag, bool bEnabled)
+    {
+        if(bEnabled)
+            sceneDesc.flags.set(flag);
+        else
+            sceneDesc.flags.clear(flag);
+    };
+    setSceneFlag(PxSceneFlag::eENABLE_ACTIVE_ACTORS, mConfig.bActiveActors);
+    setSceneFlag(PxSceneFlag::eENABLE_PCM, mConfig.bPCM);
+    setSceneFlag(PxSceneFlag::eENABLE_CCD, mConfig.bCCD);
+    setSceneFlag(PxSceneFlag::eENABLE_ENHANCED_DETERMINISM, mConfig.bEnhancedDeterminism);
+    PxScene* scene = mPhysics->createScene(sceneDesc);
+    if(!scene)
+        return scene;
+
+    //MBP only sees objects inside its regions, Z is up so the grid is cut along X and Y
+    if(mConfig.broadphase == PhysicsConfig::Broadphase::MBP)
+    {
+        //MBP takes at most 256 regions
+        const PxU32 subdivisions = PxClamp(mConfig.mbpSubdivisions, 1u, 16u);
+        std::vector<PxBroadPhaseRegion> regions(subdivisions * subdivisions);
+        PxU32 count = PxBroadPhaseExt::createRegionsFromWorldBounds(regions.data(), bounds, subdivisions, 2);
+        for(PxU32 i = 0; i < count; i++)
+            scene->addBroadPhaseRegion(regions[i]);
+    }
+    setVisualization(scene, mConfig.bDebugDraw);
+    return scene;
+}
+
+//A visualization scale of 0 makes PhysX skip filling the render buffer completely
+void PhysicsComponent::setVisualization(PxScene* scene, bool bEnabled)
+{
+    scene->setVisualizationParameter(PxVisualizationParameter::eSCALE, bEnabled ? 1.f : 0.f);
+    scene->setVisualizationParameter(PxVisualizationParameter::eCOLLISION_SHAPES, bEnabled ? 1.f : 0.f);
+    scene->setVisualizationParameter(PxVisualizationParameter::eACTOR_AXES, bEnabled ? 1.f : 0.f);
+}
+
+void PhysicsComponent::setDebugDraw(bool bEnabled)
+{
+    mConfig.bDebugDraw = bEnabled;
+    setVisualization(mScene, bEnabled);
+    for(PxScene* scene : mRegionScenes)
+        setVisualization(scene, bEnabled);
+}
+
+PxActor** PhysicsComponent::activeActors(PxU32& count)
+{
+    count = 0;
+    if(!mConfig.bActiveActors)
+        return nullptr;
+    return mScene->getActiveActors(count);
+}
+
 void PhysicsComponent::simulationStep(float dt)
 {
+  mStepTimer.start();
+  mContacts.clear();
+  mActivity.update(mActivityCenter);
+  mRegions.update(mActivityCenter);
+  //everything is started before waiting on anything, so the main scene and the regions run side by side
   mScene->simulate(dt);
+  mRegions.simulate(dt);
   mScene->fetchResults(true);
+  mRegions.fetchResults();
+  if(mRegions.enabled())
+  {
+      //regions that loaded this step came up with debug draw from the config already
+      mRegions.loadedScenes(mRegionScenes);
+      mRegions.dynamics(mRegionBodies, false);
+      mQueries.setRegionScenes(mRegionScenes);
+  }
+  mQueries.execute();
+  mRecorder.step(mStepTimer.nsecsElapsed() / 1000000.0, mRegionBodies);
 }
 
 //convex mesh without serilazation
-void PhysicsComponent::createDynamic(GameObject* obj, const char *name, PxTransform pose, PxPhysics* physics, PxCooking* cooking, PxScene* scene)
+void PhysicsComponent::createDynamic(GameObject* obj, const char *name, PxTransform pose)
 {
-    PxRigidDynamic* dynamic = nullptr;
-    PxCookingParams parameter = cooking->getParams();
+    addDynamic(cookConvexMesh(obj->vertices(), obj->indecies()), name, pose);
+}
 
-    PxConvexMesh* mesh;
-    PxConvexMeshDesc meshDescription;
-    std::vector<Vertex> verticies = obj->vertices();
-    std::vector<GLuint>indices = obj->indecies();
-    std::vector<PxU16> tempIndecies;
-    std::vector<PxVec3> tempVerticies;
-    std::vector<PxVec3> tempPolygons;
+//Only talks to PxCooking/PxPhysics, never the scene, so it can run on a worker thread.
+//The descriptor points straight at the render vertices, the position is the first three floats
+//of every Vertex (same as attribute 0 in GraphicsComponent::init()), so nothing is copied
+PxConvexMesh* PhysicsComponent::cookConvexMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    PX_UNUSED(indices);     //the hull is computed from the points, the render triangles don't matter
+    if(vertices.empty())
+        return nullptr;
 
-    parameter.convexMeshCookingType = PxConvexMeshCookingType::eQUICKHULL;
+    PxConvexMeshDesc meshDescription;
+    meshDescription.points.count = static_cast<PxU32>(vertices.size());
+    meshDescription.points.stride = sizeof(Vertex);
+    meshDescription.points.data = vertices.data();
+    meshDescription.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+    setVertexLimit(meshDescription, mConfig.hullVertexLimit);
 
-    for(auto i = 0; i < verticies.size();i++)
-    {
-       float tX = verticies[i].getX();
-       float tY = verticies[i].getY();
-       float tZ = verticies[i].getZ();
+    //the same mesh is only cooked once and then shared, and when it has to be
+    //cooked it goes through the on-disk cache first
+    return mRegistry.convexMesh(CookingCache::hash(meshDescription, mCooking->getParams()),
+                                [&](){ return mCookingCache.convexMesh(meshDescription); });
+}
 
-       tempVerticies.push_back(PxVec3(tX,tY,tZ));
+CollisionProxy PhysicsComponent::buildProxy(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    CollisionProxy::Settings settings;
+    settings.weldDistance = mConfig.proxyWeldDistance;
+    settings.tolerance = mConfig.proxyTolerance;
+    std::vector<PxVec3> hullPoints;
+    CollisionProxy proxy = CollisionProxy::fit(vertices, indices, settings, hullPoints);
+    if(proxy.type != CollisionProxy::Type::Convex)
+        return proxy;
 
-    }
-    for(auto i = 0 ; i< indices.size();i++){
-        tempIndecies.push_back(static_cast<PxU32>(indices[i]));
-    }
-    meshDescription.points.count = static_cast<PxU32>(tempVerticies.size());
+    PxConvexMeshDesc meshDescription;
+    meshDescription.points.count = static_cast<PxU32>(hullPoints.size());
     meshDescription.points.stride = sizeof(PxVec3);
-    meshDescription.points.data = tempVerticies.data();
+    meshDescription.points.data = hullPoints.data();
     meshDescription.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+    setVertexLimit(meshDescription, mConfig.hullVertexLimit);
+    proxy.hull = mRegistry.convexMesh(CookingCache::hash(meshDescription, mCooking->getParams()),
+                                      [&](){ return mCookingCache.convexMesh(meshDescription); });
+    if(!proxy.hull)
+        proxy.type = CollisionProxy::Type::None;
+    return proxy;
+}
 
-    meshDescription.indices.count = tempIndecies.size()/3;
-    meshDescription.indices.stride = 3*sizeof(PxU32);
-    meshDescription.indices.data =  tempIndecies.data();
+//Has to run on the thread that owns the scene
+PxRigidDynamic* PhysicsComponent::addDynamic(PxConvexMesh* mesh, const char* name, PxTransform pose)
+{
+    CollisionProxy proxy;
+    if(mesh)
+    {
+        proxy.type = CollisionProxy::Type::Convex;
+        proxy.hull = mesh;
+    }
+    return addDynamic(proxy, name, pose);
+}
 
+//Has to run on the thread that owns the scene
+PxRigidDynamic* PhysicsComponent::addDynamic(const CollisionProxy& proxy, const char* name, PxTransform pose)
+{
+    PxRigidDynamic* dynamic = createDynamicActor(proxy, name, pose);
+    if(dynamic)
+        addActors({dynamic});
+    return dynamic;
+}
 
-//    PxDefaultMemoryOutputStream bufferOutput;
+//Every dynamic is made here, so they all get the body flags the config asks for
+PxRigidDynamic* PhysicsComponent::newDynamic(const PxTransform& pose)
+{
+    PxRigidDynamic* dynamic = mPhysics->createRigidDynamic(pose);
+    dynamic->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, mConfig.bCCD);
+    return dynamic;
+}
 
-//    PxConvexMeshCookingResult::Enum result;
-//    cooking->validateConvexMesh(meshDescription);
-//    bool test=meshDescription.isValid();
-//    bool cook = cooking->cookConvexMesh(meshDescription, bufferOutput, &result);
-//    if(!cook)
-//        std::cout << "Cooking failed";
+//The actor is made but not added, so a whole batch can go into the scene at once with addActors()
+PxRigidDynamic* PhysicsComponent::createDynamicActor(const CollisionProxy& proxy, const char* name, PxTransform pose)
+{
+    PxRigidDynamic* dynamic = nullptr;
+    if(!proxy.valid())
+        return dynamic;
+
+    //every dynamic of the same mesh shares one shape
+    PxShape* shape = mRegistry.shape(proxy.geometry().any(), mMaterial, proxy.localPose);
+    if(proxy.hull)
+        mRegistry.release(proxy.hull);    //the shape holds on to the mesh now
+    if(!shape)
+        return dynamic;
+    dynamic = newDynamic(pose);
+    dynamic->attachShape(*shape);
+    PxRigidBodyExt::updateMassAndInertia(*dynamic, 1.f);
+    dynamic->setName(name);
+    return dynamic;
+}
 
-//    PxDefaultMemoryInputData bufferInput(bufferOutput.getData(),bufferOutput.getSize());
+//With the region grid on, dynamics go into the region they are in instead of the main scene.
+//Statics stay in the main scene, which answers the scene queries, and are copied into every
+//region they overlap. Dynamics are kept in mRigidBodies either way so update() can sync them
+void PhysicsComponent::addActors(const std::vector<PxRigidActor*>& actors)
+{
+    if(actors.empty())
+        return;
+    std::vector<PxActor*> batch;
+    batch.reserve(actors.size());
+    for(PxRigidActor* actor : actors)
+    {
+        if(PxRigidDynamic* dynamic = actor->is<PxRigidDynamic>())
+        {
+            mRigidBodies.push_back(actor);
+            if(mRegions.enabled())
+            {
+                mRegions.addDynamic(dynamic);
+                continue;
+            }
+        }
+        else if(mRegions.enabled())
+            addToRegions(actor);
+        batch.push_back(actor);
+    }
+    if(!batch.empty())
+        mScene->addActors(batch.data(), static_cast<PxU32>(batch.size()));
+}
 
-//    mesh = physics->createConvexMesh(bufferInput);//mCooking->createConvexMesh(meshDescription,mPhysics->getPhysicsInsertionCallback());
+void PhysicsComponent::addToRegions(PxRigidActor* actor)
+{
+    std::vector<PxShape*> shapes(actor->getNbShapes());
+    actor->getShapes(shapes.data(), static_cast<PxU32>(shapes.size()));
+    for(PxShape* shape : shapes)
+    {
+        //a region static has one material
+        PxMaterial* material = mMaterial;
+        shape->getMaterials(&material, 1);
+        mRegions.addStatic(shape->getGeometry().any(), material, actor->getGlobalPose() * shape->getLocalPose(), actor->getName());
+    }
+}
 
-    mesh = cooking->createConvexMesh(meshDescription,physics->getPhysicsInsertionCallback());
-    PxConvexMeshGeometry convexGeo(mesh);
+void PhysicsComponent::creatStaticPhysics(GameObject* obj, const char* name, PxTransform pose)
+{
+    addStatic(cookTriangleMesh(obj->vertices(), obj->indecies()), name, pose);
+}
 
+//Only talks to PxCooking/PxPhysics, never the scene, so it can run on a worker thread.
+//Like cookConvexMesh() the descriptor uses the render buffers as they are
+PxTriangleMesh* PhysicsComponent::cookTriangleMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    static_assert(sizeof(GLuint) == sizeof(PxU32), "the index buffer is handed to PhysX as PxU32");
+    if(vertices.empty() || indices.size() < 3)
+        return nullptr;
+
+    PxTriangleMeshDesc triangleDescription;
+    triangleDescription.points.count = static_cast<PxU32>(vertices.size());
+    triangleDescription.points.stride = sizeof(Vertex);
+    triangleDescription.points.data = vertices.data();
+
+    triangleDescription.triangles.count = static_cast<PxU32>(indices.size() / 3);
+    triangleDescription.triangles.stride = 3 * sizeof(PxU32);
+    triangleDescription.triangles.data = indices.data();
+
+    //cooks through the on-disk cache, the terrain is only cooked when it has changed
+    return mRegistry.triangleMesh(CookingCache::hash(triangleDescription, mCooking->getParams()),
+                                  [&](){ return mCookingCache.triangleMesh(triangleDescription); });
+}
 
-    mMaterial = physics->createMaterial(0.5,0.5,0.5);
-    dynamic = PxCreateDynamic(*physics,pose,convexGeo,*mMaterial,1.f);//*mPhysics, pose, convexGeo, *mMaterial);
-    dynamic->setName(name);
-    scene->addActor(*dynamic);
-    mRigidBodies.push_back(dynamic);
+//Has to run on the thread that owns the scene
+PxRigidStatic* PhysicsComponent::addStatic(PxTriangleMesh* mesh, const char* name, PxTransform pose)
+{
+    PxRigidStatic* mTerrain = createStaticActor(mesh, name, pose);
+    if(mTerrain)
+        addActors({mTerrain});
+    return mTerrain;
 }
-void PhysicsComponent::creatStaticPhysics(GameObject* obj, const char* name, PxTransform pose)
+
+PxRigidStatic* PhysicsComponent::createStaticActor(PxTriangleMesh* mesh, const char* name, PxTransform pose)
 {
-        PxTriangleMesh* triogem;
-        PxTriangleMeshDesc triangleDescription;
+         PxRigidStatic* mTerrain = nullptr;
+         if(!mesh)
+             return mTerrain;
+         PxTriangleMeshGeometry trigeo(mesh);
+         PxShape* shape = mRegistry.shape(trigeo, mMaterial);
+         mRegistry.release(mesh);   //the shape holds on to the mesh now
+         if(!shape)
+             return mTerrain;
+         mTerrain = mPhysics->createRigidStatic(pose);
+         mTerrain->attachShape(*shape);
+         mTerrain->setName(name);
+         return mTerrain;
+}
 
-        PxRigidStatic* mTerrain;
-        std::vector<Vertex> tempVertices = obj->vertices();
-        std::vector<GLuint> tempIndices = obj->indecies();
+TerrainShape PhysicsComponent::cookTerrain(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    if(mConfig.terrainMode != PhysicsConfig::TerrainMode::TriangleMesh)
+    {
+        HeightGrid grid;
+        if(HeightGrid::fromVertices(vertices, grid))
+            return cookHeightField(grid);
+        if(mConfig.terrainMode == PhysicsConfig::TerrainMode::HeightField)
+            std::cout << "terrain is not a regular grid, using a triangle mesh instead of a height field\n";
+    }
+    TerrainShape terrain;
+    terrain.triangleMesh = cookTriangleMesh(vertices, indices);
+    return terrain;
+}
 
-        std::vector<PxU32> PxIndecies;
-        std::vector<PxVec3> PxVerticies;
-        for(auto i = 0; i < tempVertices.size(); i++)
-        {
-             PxReal px = tempVertices[i].getX();
-             PxReal py = tempVertices[i].getY();
-             PxReal pz = tempVertices[i].getZ();
+TerrainShape PhysicsComponent::cookHeightField(const HeightGrid& grid)
+{
+    TerrainShape terrain;
+    if(grid.rows < 2 || grid.columns < 2)
+        return terrain;
+
+    PxReal maxHeight = 0.f;
+    for(PxReal height : grid.heights)
+        maxHeight = PxMax(maxHeight, PxAbs(height));
+    //Heights are stored as PxI16, spread them over the whole range
+    terrain.heightScale = maxHeight > 0.f ? maxHeight / PxReal(PX_MAX_I16) : 1.f;
+    terrain.rowScale = grid.rowScale;
+    terrain.columnScale = grid.columnScale;
+
+    std::vector<PxHeightFieldSample> samples(grid.heights.size());
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i].height = static_cast<PxI16>(PxClamp(grid.heights[i] / terrain.heightScale, PxReal(-PX_MAX_I16), PxReal(PX_MAX_I16)));
+
+    PxHeightFieldDesc description;
+    description.format = PxHeightFieldFormat::eS16_TM;
+    description.nbRows = grid.rows;
+    description.nbColumns = grid.columns;
+    description.samples.data = samples.data();
+    description.samples.stride = sizeof(PxHeightFieldSample);
+
+    terrain.heightField = mCooking->createHeightField(description, mPhysics->getPhysicsInsertionCallback());
+    if(!terrain.heightField)
+        std::cout << "height field creation failed";
+
+    //PhysX height fields are Y up with rows along X and columns along Z.
+    //Rotating 120 degrees around (1,1,1) takes local X->Y, Y->Z, Z->X,
+    //which lines the rows up with world Y, columns with world X and heights with world Z
+    terrain.localPose = PxTransform(grid.origin, PxQuat(0.5f, 0.5f, 0.5f, 0.5f));
+    return terrain;
+}
 
-             PxVerticies.push_back(PxVec3(px,py,pz));
-        }
-        for(auto i = 0; i< tempIndices.size(); i++)
-        {
-            PxIndecies.push_back(static_cast<PxU32>(tempIndices[i]));
-        }
+PxRigidStatic* PhysicsComponent::addTerrain(const TerrainShape& terrain, const char* name)
+{
+    if(!terrain.valid())
+        return nullptr;
+
+    PxRigidStatic* actor = mPhysics->createRigidStatic(PxTransform(PxIdentity));
+    PxShape* shape = PxRigidActorExt::createExclusiveShape(*actor, terrain.geometry().any(), *mMaterial);
+    shape->setLocalPose(terrain.localPose);
+    //the shape holds on to the mesh now. Height fields come straight from PxCooking, not the registry
+    if(terrain.triangleMesh)
+        mRegistry.release(terrain.triangleMesh);
+    if(terrain.heightField)
+        terrain.heightField->release();
+    actor->setName(name);
+    addActors({actor});
+    return actor;
+}
 
-       triangleDescription.points.count = (PxU32)PxVerticies.size();
-       triangleDescription.points.stride = sizeof(PxVec3);
-       triangleDescription.points.data = PxVerticies.data();
+//The caller's reference to a cooked mesh. Height fields come straight from PxCooking, not the registry
+void PhysicsComponent::releaseMesh(const PxGeometry& geometry)
+{
+    if(geometry.getType() == PxGeometryType::eCONVEXMESH)
+        mRegistry.release(static_cast<const PxConvexMeshGeometry&>(geometry).convexMesh);
+    else if(geometry.getType() == PxGeometryType::eTRIANGLEMESH)
+        mRegistry.release(static_cast<const PxTriangleMeshGeometry&>(geometry).triangleMesh);
+    else if(geometry.getType() == PxGeometryType::eHEIGHTFIELD)
+        static_cast<const PxHeightFieldGeometry&>(geometry).heightField->release();
+}
 
-       triangleDescription.triangles.count = (PxU32)PxIndecies.size()/3;
-       triangleDescription.triangles.stride = 3*sizeof(PxU32);
-       triangleDescription.triangles.data = PxIndecies.data();
+PxRigidActor* PhysicsComponent::findActor(const char* name)
+{
+    PxActorTypeFlags types = PxActorTypeFlag::eRIGID_STATIC | PxActorTypeFlag::eRIGID_DYNAMIC;
+    std::vector<PxActor*> actors(mScene->getNbActors(types));
+    mScene->getActors(types, actors.data(), static_cast<PxU32>(actors.size()));
+    for(PxActor* actor : actors)
+    {
+        if(actor->getName() && std::strcmp(actor->getName(), name) == 0)
+            return actor->is<PxRigidActor>();
+    }
+    //dynamics in the region grid are not in the main scene
+    for(PxRigidActor* actor : mRigidBodies)
+    {
+        if(actor->getName() && std::strcmp(actor->getName(), name) == 0)
+            return actor;
+    }
+    return nullptr;
+}
 
+void PhysicsComponent::replaceCollision(PxRigidActor* actor, const PxGeometry& geometry, const PxTransform& localPose)
+{
+    if(!actor)
+    {
+        releaseMesh(geometry);
+        return;
+    }
+    //Keep the material and filter data (contact reports) the actor already had
+    PxMaterial* material = mMaterial;
+    PxFilterData filter;
+    std::vector<PxShape*> shapes(actor->getNbShapes());
+    actor->getShapes(shapes.data(), static_cast<PxU32>(shapes.size()));
+    if(!shapes.empty())
+    {
+        shapes[0]->getMaterials(&material, 1);
+        filter = shapes[0]->getSimulationFilterData();
+    }
 
-       PxDefaultMemoryOutputStream buffer;
+    PxShape* shape = mRegistry.shape(geometry, material, localPose, filter);
+    //the shape holds on to the mesh now
+    releaseMesh(geometry);
+    if(!shape)
+    {
+        std::cout << "could not create the reloaded collision shape";
+        return;
+    }
+    mRegistry.releaseShapes(actor);
+    actor->attachShape(*shape);
 
-       PxTriangleMeshCookingResult::Enum result;
+    if(PxRigidDynamic* dynamic = actor->is<PxRigidDynamic>())
+    {
+        PxRigidBodyExt::updateMassAndInertia(*dynamic, 1.f);
+        dynamic->wakeUp();
+    }
+}
 
-        mCooking->validateTriangleMesh(triangleDescription);
-        bool stat = mCooking->cookTriangleMesh(triangleDescription, buffer, &result);
-         if(!stat){
-              std::cout << "cooking failed";
-         }
+void PhysicsComponent::releaseActor(PxRigidActor* actor)
+{
+    mActivity.forget(actor);
+    mRecorder.forget(actor);
+    if(PxRigidDynamic* dynamic = actor->is<PxRigidDynamic>())
+        mRegions.forget(dynamic);
+    if(actor->getScene())
+        actor->getScene()->removeActor(*actor);
+    auto found = std::find(mRigidBodies.begin(), mRigidBodies.end(), actor);
+    if(found != mRigidBodies.end())
+        mRigidBodies.erase(found);
+    mRegistry.releaseShapes(actor);
+    actor->release();
+}
 
-        PxDefaultMemoryInputData bufferInput(buffer.getData(),buffer.getSize());
+void PhysicsComponent::setContactReports(PxRigidActor* actor, bool bEnabled)
+{
+    if(!actor)
+        return;
+    //Shapes are shared, so the actor swaps to the variant with the other filter data
+    std::vector<PxShape*> shapes(actor->getNbShapes());
+    actor->getShapes(shapes.data(), static_cast<PxU32>(shapes.size()));
+    std::vector<PxShape*> replacements;
+    for(PxShape* shape : shapes)
+    {
+        PxFilterData filter = shape->getSimulationFilterData();
+        filter.word0 = bEnabled ? (filter.word0 | ReportContacts) : (filter.word0 & ~PxU32(ReportContacts));
+        PxMaterial* material = mMaterial;
+        shape->getMaterials(&material, 1);
+        replacements.push_back(mRegistry.shape(shape->getGeometry().any(), material, shape->getLocalPose(), filter));
+    }
+    mRegistry.releaseShapes(actor);
+    for(PxShape* shape : replacements)
+    {
+        if(shape)
+            actor->attachShape(*shape);
+    }
+}
 
-         triogem = mPhysics->createTriangleMesh(bufferInput);
-         mMaterial = mPhysics->createMaterial(0.5,0.5,0.5);
+bool PhysicsComponent::exportScene(const std::string& fileName)
+{
+    //parked bodies may not even be in the scene
+    mActivity.restoreAll();
+    std::vector<PxRigidDynamic*> regionBodies;
+    mRegions.dynamics(regionBodies, true);
+    return mSerializer.exportScene(mScene, fileName, regionBodies);
+}
 
-         PxTransform transform(PxVec3(0.0f, 0.0f, 0.0f));
-         PxTriangleMeshGeometry trigeo(triogem);
-         mTerrain = PxCreateStatic(*mPhysics,transform,trigeo,*mMaterial);
-         mTerrain->setName(name);
+//The live scene is put back the way it was afterwards, so the game carries on as if nothing happened
+bool PhysicsComponent::exportSnapshot(size_t snapshot, const std::string& fileName)
+{
+    if(snapshot >= mRecorder.size())
+        return false;
+    mActivity.restoreAll();
+    std::vector<PhysicsRecorder::BodyState> states;
+    std::vector<PxRigidDynamic*> bodies;
+    mRecorder.capture(states, bodies);
+    mRecorder.restore(snapshot);
+    std::vector<PxRigidDynamic*> regionBodies;
+    mRegions.dynamics(regionBodies, true);
+    bool bSaved = mSerializer.exportScene(mScene, fileName, regionBodies);
+    mRecorder.apply(states, bodies);
+    return bSaved;
+}
 
-         mScene->addActor(*mTerrain);
+bool PhysicsComponent::importScene(const std::string& fileName)
+{
+    PxCollection* collection = mSerializer.importScene(fileName);
+    if(!collection)
+        return false;
+    //through addActors() like everything else, so the dynamics end up in the RegionGrid when it is on.
+    //Joints follow their actors into the scene by themselves
+    std::vector<PxRigidActor*> actors;
+    for(PxU32 i = 0; i < collection->getNbObjects(); i++)
+    {
+        PxRigidActor* actor = collection->getObject(i).is<PxRigidActor>();
+        if(!actor)
+            continue;
+        actors.push_back(actor);
+        PxSerialObjectId id = collection->getId(*actor);
+        if(id != PX_SERIAL_OBJECT_ID_INVALID)
+            mImported[id] = actor;
+    }
+    addActors(actors);
+    collection->release();
+    return true;
+}
+
+PxRigidActor* PhysicsComponent::linkActor(const char* name, const PxTransform& spawnPose)
+{
+    auto found = mImported.find(SceneSerializer::id(name));
+    if(found == mImported.end())
+        return nullptr;
+    PxRigidActor* actor = found->second;
+    mImported.erase(found);
+    actor->setName(name);
+    if(PxRigidDynamic* dynamic = actor->is<PxRigidDynamic>())
+    {
+        //statics never move, so only the dynamics can have been saved somewhere else
+        dynamic->setGlobalPose(spawnPose);
+        dynamic->setLinearVelocity(PxVec3(0));
+        dynamic->setAngularVelocity(PxVec3(0));
+    }
+    return actor;
 }
 
 void PhysicsComponent::createTestDynamic()
 {
+  PxShape* shape = mRegistry.shape(PxSphereGeometry(1), mMaterial);
+  if(!shape)
+      return;
   PxRigidDynamic* dynamic;
-  PxMaterial* mat = mPhysics->createMaterial(0.5f, 0.5f, 0.5f);
-  dynamic = PxCreateDynamic(*mPhysics,PxTransform(PxVec3(0,0,10)),PxSphereGeometry(1),*mat,1.f);
+  dynamic = newDynamic(PxTransform(PxVec3(0,0,10)));
+  dynamic->attachShape(*shape);
+  PxRigidBodyExt::updateMassAndInertia(*dynamic, 1.f);
   dynamic->setAngularVelocity(PxVec3(0,0,10));
   dynamic->setMass(100);
   mScene->addActor(*dynamic);
@@ -208,28 +703,36 @@ void PhysicsComponent::update(GameObject *obj)
 
 void PhysicsComponent::helloWorldSnippets()
 {
-    mMaterial = mPhysics->createMaterial(0.5f, 0.5f, 0.6f);
+    PxMaterial* material = mRegistry.material(0.5f, 0.5f, 0.6f);
 
-        PxRigidStatic* groundPlane = PxCreatePlane(*mPhysics, PxPlane(0,0,1,0), *mMaterial);
+        PxRigidStatic* groundPlane = PxCreatePlane(*mPhysics, PxPlane(0,0,1,0), *material);
         mScene->addActor(*groundPlane);
 
     const PxTransform t(PxVec3(0,5,10));
             PxU32 size = 10;
     PxReal halfExtent = 10;
-    PxShape* shape = mPhysics->createShape(PxBoxGeometry(halfExtent, halfExtent, halfExtent), *mMaterial);
+    PxShape* shape = mRegistry.shape(PxBoxGeometry(halfExtent, halfExtent, halfExtent), material);
+    if(!shape)
+        return;
     for(PxU32 i=0; i<size;i++)
     {
         for(PxU32 j=0;j<size-i;j++)
         {
             PxTransform localTm(PxVec3(PxReal(j*2) - PxReal(size-i), PxReal(i*2+1), 0) * halfExtent);
-            PxRigidDynamic* body = mPhysics->createRigidDynamic(t.transform(localTm));
+            PxRigidDynamic* body = newDynamic(t.transform(localTm));
             body->attachShape(*shape);
+            mRegistry.retain(shape);    //one reference per body, see releaseActor
             PxRigidBodyExt::updateMassAndInertia(*body, 10.0f);
             mScene->addActor(*body);
         }
     }
-    shape->release();
-    PxRigidDynamic* dynamic = PxCreateDynamic(*mPhysics, t, PxSphereGeometry(1), *mMaterial, 10.0f);
+    mRegistry.release(shape);
+    PxShape* sphere = mRegistry.shape(PxSphereGeometry(1), material);
+    if(!sphere)
+        return;
+    PxRigidDynamic* dynamic = newDynamic(t);
+    dynamic->attachShape(*sphere);
+    PxRigidBodyExt::updateMassAndInertia(*dynamic, 10.0f);
     dynamic->setAngularDamping(0.5f);
     dynamic->setLinearVelocity(PxVec3(0,10,10));
     mScene->addActor(*dynamic);
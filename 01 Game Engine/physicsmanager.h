@@ -16,6 +16,20 @@
 #include "vertex.h"
 #include "QOpenGLFunctions_4_1_Core"
 #include "gameobject.h"
+#include "physicsconfig.h"
+#include "cookingcache.h"
+#include "terrainshape.h"
+#include "physicsregistry.h"
+#include "jobdispatcher.h"
+#include "scenequerybatch.h"
+#include "sceneserializer.h"
+#include "collisionproxy.h"
+#include "contactreporter.h"
+#include "activitymanager.h"
+#include "regiongrid.h"
+#include "physicsrecorder.h"
+#include <QElapsedTimer>
+#include <unordered_map>
 
 using namespace physx;
 
@@ -24,13 +38,74 @@ class PhysicsComponent
 public:
     PhysicsComponent();
     ~PhysicsComponent();
-    void initPhysics();
+    void initPhysics(const PhysicsConfig& config = PhysicsConfig());
+    const PhysicsConfig& config() const {return mConfig;}
+    void setDebugDraw(bool bEnabled);
+    bool debugDraw() const {return mConfig.bDebugDraw;}
     void simulationStep(float dt);
+    //Where the player is, bodies far from it stop being simulated (PhysicsConfig::activityRadius)
+    void setActivityCenter(const PxVec3& center){mActivityCenter = center;}
+    //Actors that moved in the last step, only with PhysicsConfig::bActiveActors
+    PxActor** activeActors(PxU32& count);
     PxPhysics*  getPhysics(){return mPhysics;}
     PxScene*    getScene(){return mScene;}
     PxCooking*  getCooking(){return mCooking;}
-    void createDynamic(GameObject* obj, const char* name, PxTransform pose, PxPhysics *physics, PxCooking *cooking, PxScene *scene);
+    PhysicsRegistry& registry(){return mRegistry;}
+    //Streamed world regions, only used when PhysicsConfig::regionSize is set
+    RegionGrid& regions(){return mRegions;}
+    //The loaded region scenes as of the last step, for anything that has to look at all of them (debug draw)
+    const std::vector<PxScene*>& regionScenes() const {return mRegionScenes;}
+    ContactReporter& contactReporter(){return mContacts;}
+    //A scene set up from the config on the shared dispatcher. bounds are used for MBP regions
+    PxScene* createScene(PxSimulationEventCallback* callback, const PxBounds3& bounds);
+    //Queue raycasts/sweeps/overlaps here, they run in parallel right after the next step
+    SceneQueryBatch& queries(){return mQueries;}
+    void createDynamic(GameObject* obj, const char* name, PxTransform pose);
     void creatStaticPhysics(GameObject* obj, const char *name, PxTransform pose);
+    //Split versions of the two above for the AssetManager:
+    //cooking is safe on a worker thread, adding to the scene has to happen on the owning thread
+    PxConvexMesh* cookConvexMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    PxTriangleMesh* cookTriangleMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    PxRigidDynamic* addDynamic(PxConvexMesh* mesh, const char* name, PxTransform pose);
+    //Cheapest collision that is close enough to the mesh, see CollisionProxy. Worker thread safe
+    CollisionProxy buildProxy(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    PxRigidDynamic* addDynamic(const CollisionProxy& proxy, const char* name, PxTransform pose);
+    //An empty dynamic with the config's body flags (CCD), anything that makes a dynamic goes through this
+    PxRigidDynamic* newDynamic(const PxTransform& pose);
+    //Same as addDynamic/addStatic without adding to the scene, for inserting many actors in one go
+    PxRigidDynamic* createDynamicActor(const CollisionProxy& proxy, const char* name, PxTransform pose);
+    PxRigidStatic* createStaticActor(PxTriangleMesh* mesh, const char* name, PxTransform pose);
+    //Goes through the region grid when it is on, see addActors() in the .cpp
+    void addActors(const std::vector<PxRigidActor*>& actors);
+    PxRigidStatic* addStatic(PxTriangleMesh* mesh, const char* name, PxTransform pose);
+    //Terrain collision, a PxHeightField or a triangle mesh depending on PhysicsConfig::terrainMode.
+    //cookTerrain/cookHeightField are worker thread safe like the cook functions above.
+    //addTerrain takes over the mesh/height field in terrain
+    TerrainShape cookTerrain(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    TerrainShape cookHeightField(const HeightGrid& grid);
+    PxRigidStatic* addTerrain(const TerrainShape& terrain, const char* name);
+    //Used by hot reloading to swap the collision of an actor that is already in the scene
+    PxRigidActor* findActor(const char* name);
+    //Takes over the mesh in geometry, also when the actor is nullptr or the shape can't be made
+    void replaceCollision(PxRigidActor* actor, const PxGeometry& geometry, const PxTransform& localPose = PxTransform(PxIdentity));
+    //Takes the actor out of the scene and gives back its shared shapes/meshes
+    void releaseActor(PxRigidActor* actor);
+    //Contacts and trigger changes from the last step, read them after simulationStep().
+    //Contacts are only reported for actors that have setContactReports() on
+    const std::vector<ContactEvent>& contacts() const {return mContacts.events();}
+    void setContactReports(PxRigidActor* actor, bool bEnabled);
+    //Whole scene to a binary file and back, so a level can start without cooking or building actors.
+    //importScene() adds the saved actors to the scene, linkActor() then hands a named one back to its
+    //GameObject (and gives it the GameObject's name string, which update() compares against).
+    //The file has dynamics where they were when it was saved, linkActor() puts them back at spawnPose
+    bool exportScene(const std::string& fileName);
+    bool importScene(const std::string& fileName);
+    PxRigidActor* linkActor(const char* name, const PxTransform& spawnPose);
+    //Snapshots of the last steps, only with PhysicsConfig::recordInterval
+    PhysicsRecorder& recorder(){return mRecorder;}
+    //exportScene() with the bodies where they were at a recorded snapshot, for replaying a
+    //slow step in the benchmark (physicsbenchmark --replay)
+    bool exportSnapshot(size_t snapshot, const std::string& fileName);
     void createTestDynamic();
     void update(GameObject* obj);
     void helloWorldSnippets();
@@ -39,13 +114,31 @@ private:
      PxDefaultErrorCallback     mErrorCallback;
      PxFoundation*              mFoundation         = nullptr;
      PxPhysics*                 mPhysics            = nullptr;
-     PxDefaultCpuDispatcher*    mDispatcher         = nullptr;
+     PxDefaultCpuDispatcher*    mDispatcher         = nullptr;    //only when the JobSystem isn't used
+     JobDispatcher              mJobDispatcher;
      PxCudaContextManager*      mCudaCotextManager  = nullptr;
      PxScene*                   mScene              = nullptr;
      PxCooking*                 mCooking            = nullptr;
      PxMaterial*                mMaterial           = nullptr;
      PxTolerancesScale          mToleranceScale;
      PxCudaContextManagerDesc   mCudaContexDesc;
+     PhysicsConfig              mConfig;
+     CookingCache               mCookingCache;
+     PhysicsRegistry            mRegistry;
+     SceneQueryBatch            mQueries;
+     SceneSerializer            mSerializer;
+     ContactReporter            mContacts;
+     ActivityManager            mActivity;
+     RegionGrid                 mRegions;
+     PhysicsRecorder            mRecorder;
+     QElapsedTimer              mStepTimer;
+     PxVec3                     mActivityCenter     {0.f, 0.f, 0.f};
+     std::vector<PxScene*>      mRegionScenes;
+     std::vector<PxRigidDynamic*> mRegionBodies;     //loaded ones, for the recorder
+     void addToRegions(PxRigidActor* actor);
+     void setVisualization(PxScene* scene, bool bEnabled);
+     void releaseMesh(const PxGeometry& geometry);
+     std::unordered_map<PxSerialObjectId, PxRigidActor*> mImported;  //waiting for linkActor()
 
 public:
     std::vector<PxRigidActor*> mRigidBodies;
@@ -0,0 +1,187 @@
+#include "physicsrecorder.h"
+#include <algorithm>
+#include <cstring>
+
+void PhysicsRecorder::setup(PxScene* scene, PxU32 interval, PxU32 capacity)
+{
+    mScene = scene;
+    mInterval = interval;
+    mCapacity = capacity > 0 ? capacity : 1;
+}
+
+bool PhysicsRecorder::same(const BodyState& a, const BodyState& b)
+{
+    //Bit exact, a body that moved the tiniest bit is stored, the replay is off enough as it is
+    return a.bSleeping == b.bSleeping &&
+           std::memcmp(&a.pose, &b.pose, sizeof(PxTransform)) == 0 &&
+           std::memcmp(&a.linearVelocity, &b.linearVelocity, sizeof(PxVec3)) == 0 &&
+           std::memcmp(&a.angularVelocity, &b.angularVelocity, sizeof(PxVec3)) == 0;
+}
+
+PhysicsRecorder::BodyState PhysicsRecorder::read(PxRigidDynamic* body)
+{
+    return {body->getGlobalPose(), body->getLinearVelocity(), body->getAngularVelocity(), body->isSleeping()};
+}
+
+void PhysicsRecorder::write(PxRigidDynamic* body, const BodyState& state)
+{
+    body->setGlobalPose(state.pose);
+    //waiting for its region to load, it can't be woken or put to sleep outside a scene
+    if(!body->getScene())
+        return;
+    //parked as kinematic by the ActivityManager, velocities can't be set on those
+    if(body->getRigidBodyFlags() & PxRigidBodyFlag::eKINEMATIC)
+        return;
+    if(state.bSleeping)
+    {
+        body->putToSleep();
+        return;
+    }
+    body->setLinearVelocity(state.linearVelocity);
+    body->setAngularVelocity(state.angularVelocity);
+    body->wakeUp();
+}
+
+void PhysicsRecorder::step(double stepMs, const std::vector<PxRigidDynamic*>& extraBodies)
+{
+    if(!enabled())
+        return;
+    if(mStepsSinceLast == 0 || stepMs > mSlowestSinceLast)
+    {
+        mSlowestSinceLast = stepMs;
+        mSlowestOffset = mStepsSinceLast;
+    }
+    mStepsSinceLast++;
+    if(mStep++ % mInterval != 0)
+        return;
+
+    Frame frame;
+    frame.step = mStep;
+    frame.stepMs = mSlowestSinceLast;
+    frame.slowOffset = mSlowestOffset;
+    mSlowestSinceLast = 0.0;
+    mStepsSinceLast = 0;
+
+    mActors.resize(mScene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+    mScene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, mActors.data(), static_cast<PxU32>(mActors.size()));
+    mActors.insert(mActors.end(), extraBodies.begin(), extraBodies.end());
+    for(PxActor* actor : mActors)
+    {
+        PxRigidDynamic* body = static_cast<PxRigidDynamic*>(actor);
+        auto found = mIndices.find(body);
+        PxU32 index;
+        if(found == mIndices.end())
+        {
+            index = static_cast<PxU32>(mBodies.size());
+            mIndices.emplace(body, index);
+            mBodies.push_back(body);
+            mBase.emplace_back();
+            mBaseKnown.push_back(false);
+            mLatest.emplace_back();
+            mLatestKnown.push_back(false);
+        }
+        else
+            index = found->second;
+
+        BodyState state = read(body);
+        if(mLatestKnown[index] && same(state, mLatest[index]))
+            continue;
+        mLatest[index] = state;
+        mLatestKnown[index] = true;
+        frame.changes.push_back({index, state});
+    }
+    mFrames.push_back(std::move(frame));
+
+    //The oldest frame folds into the base state
+    if(mFrames.size() > mCapacity)
+    {
+        for(const Change& change : mFrames.front().changes)
+        {
+            mBase[change.body] = change.state;
+            mBaseKnown[change.body] = true;
+        }
+        mFrames.pop_front();
+    }
+}
+
+size_t PhysicsRecorder::slowest() const
+{
+    size_t slowest = mFrames.size() > 1 ? 1 : 0;
+    for(size_t i = 2; i < mFrames.size(); i++)
+    {
+        if(mFrames[i].stepMs > mFrames[slowest].stepMs)
+            slowest = i;
+    }
+    return slowest;
+}
+
+void PhysicsRecorder::stateAt(size_t snapshot, std::vector<BodyState>& states, std::vector<bool>& known) const
+{
+    states = mBase;
+    known = mBaseKnown;
+    for(size_t i = 0; i <= snapshot && i < mFrames.size(); i++)
+    {
+        for(const Change& change : mFrames[i].changes)
+        {
+            states[change.body] = change.state;
+            known[change.body] = true;
+        }
+    }
+}
+
+void PhysicsRecorder::restore(size_t snapshot)
+{
+    if(snapshot >= mFrames.size())
+        return;
+    std::vector<BodyState> states;
+    std::vector<bool> known;
+    stateAt(snapshot, states, known);
+    for(size_t i = 0; i < mBodies.size(); i++)
+    {
+        if(known[i] && mBodies[i])
+            write(mBodies[i], states[i]);
+    }
+}
+
+void PhysicsRecorder::rewind(size_t snapshot)
+{
+    if(snapshot >= mFrames.size())
+        return;
+    restore(snapshot);
+    //What is in the scene now is the newest state, later snapshots don't follow from it any more
+    mFrames.erase(mFrames.begin() + snapshot + 1, mFrames.end());
+    stateAt(snapshot, mLatest, mLatestKnown);
+    mSlowestSinceLast = 0.0;
+    mStepsSinceLast = 0;
+}
+
+void PhysicsRecorder::capture(std::vector<BodyState>& states, std::vector<PxRigidDynamic*>& bodies) const
+{
+    states.clear();
+    bodies.clear();
+    for(PxRigidDynamic* body : mBodies)
+    {
+        if(!body)
+            continue;
+        bodies.push_back(body);
+        states.push_back(read(body));
+    }
+}
+
+void PhysicsRecorder::apply(const std::vector<BodyState>& states, const std::vector<PxRigidDynamic*>& bodies)
+{
+    for(size_t i = 0; i < bodies.size() && i < states.size(); i++)
+        write(bodies[i], states[i]);
+}
+
+void PhysicsRecorder::forget(PxRigidActor* actor)
+{
+    PxRigidDynamic* body = actor->is<PxRigidDynamic>();
+    if(!body)
+        return;
+    auto found = mIndices.find(body);
+    if(found == mIndices.end())
+        return;
+    mBodies[found->second] = nullptr;
+    mIndices.erase(found);
+}
@@ -0,0 +1,93 @@
+#ifndef PHYSICSRECORDER_H
+#define PHYSICSRECORDER_H
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Keeps the last few hundred snapshots of every dynamic in the scene (pose, velocities, asleep or not)
+//so a moment can be looked at again, rewound to, or saved for the benchmark.
+//Only bodies that changed since the snapshot before are stored. The state at the oldest snapshot
+//is kept in full and the rest are applied on top of it, so a body resting on the ground costs nothing.
+//Simulating on from a restored snapshot is close to what happened, not the same: only the bodies
+//are put back, the contact cache, friction anchors and broadphase pairs stay as they are now.
+//Good enough to look at a moment or time a slow step again, not to replay a game.
+class PhysicsRecorder
+{
+public:
+    struct BodyState
+    {
+        PxTransform pose;
+        PxVec3 linearVelocity;
+        PxVec3 angularVelocity;
+        bool bSleeping;
+    };
+
+    //interval 0 turns recording off
+    void setup(PxScene* scene, PxU32 interval, PxU32 capacity);
+    //Every step, after fetchResults(). stepMs is how long the step took.
+    //extraBodies are recorded along with the scene's, for dynamics that live in other scenes (RegionGrid)
+    void step(double stepMs, const std::vector<PxRigidDynamic*>& extraBodies = std::vector<PxRigidDynamic*>());
+
+    size_t size() const {return mFrames.size();}
+    PxU64 stepOf(size_t snapshot) const {return mFrames[snapshot].step;}
+    double stepMsOf(size_t snapshot) const {return mFrames[snapshot].stepMs;}
+    //Steps from the snapshot before this one to the slowest step between the two. Restoring
+    //snapshot - 1 and stepping this many times puts the scene right before that step
+    PxU32 slowOffsetOf(size_t snapshot) const {return mFrames[snapshot].slowOffset;}
+    //The snapshot taken right after the slowest recorded step. Never the first one (unless it is
+    //the only one), it has no snapshot before it to replay from
+    size_t slowest() const;
+
+    //Puts every recorded body back the way it was. Bodies made after the snapshot are left alone
+    void restore(size_t snapshot);
+    //restore() and carry on recording from there, the snapshots after it are dropped
+    void rewind(size_t snapshot);
+    //The live state, to go back to after looking at a snapshot
+    void capture(std::vector<BodyState>& states, std::vector<PxRigidDynamic*>& bodies) const;
+    void apply(const std::vector<BodyState>& states, const std::vector<PxRigidDynamic*>& bodies);
+    //The actor is being released
+    void forget(PxRigidActor* actor);
+
+    bool enabled() const {return mInterval > 0;}
+
+private:
+    struct Change
+    {
+        PxU32 body;     //index into mBodies
+        BodyState state;
+    };
+    struct Frame
+    {
+        PxU64 step;
+        double stepMs;
+        PxU32 slowOffset;
+        std::vector<Change> changes;
+    };
+
+    static bool same(const BodyState& a, const BodyState& b);
+    static BodyState read(PxRigidDynamic* body);
+    static void write(PxRigidDynamic* body, const BodyState& state);
+    void stateAt(size_t snapshot, std::vector<BodyState>& states, std::vector<bool>& known) const;
+
+    PxScene* mScene {nullptr};
+    PxU32 mInterval {0};
+    PxU32 mCapacity {0};
+    PxU64 mStep {0};
+    double mSlowestSinceLast {0.0};
+    PxU32 mSlowestOffset {0};
+    PxU32 mStepsSinceLast {0};
+    std::vector<PxRigidDynamic*> mBodies;                   //nullptr once released
+    std::unordered_map<PxRigidDynamic*, PxU32> mIndices;
+    std::vector<BodyState> mBase;                           //state before the oldest frame
+    std::vector<bool> mBaseKnown;
+    std::vector<BodyState> mLatest;                         //state after the newest frame
+    std::vector<bool> mLatestKnown;
+    std::deque<Frame> mFrames;
+    std::vector<PxActor*> mActors;                          //scratch
+};
+
+#endif // PHYSICSRECORDER_H
@@ -0,0 +1,210 @@
+#include "physicsregistry.h"
+#include <cstring>
+
+namespace
+{
+//Raw bytes of a value, used to build the lookup keys
+template<typename T>
+void appendKey(std::string& key, const T& value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void appendKey(std::string& key, const PxMeshScale& scale)
+{
+    appendKey(key, scale.scale);
+    appendKey(key, scale.rotation);
+}
+}
+
+void PhysicsRegistry::setup(PxPhysics* physics)
+{
+    mPhysics = physics;
+}
+
+PxMaterial* PhysicsRegistry::material(PxReal staticFriction, PxReal dynamicFriction, PxReal restitution)
+{
+    std::string key = "m";
+    appendKey(key, staticFriction);
+    appendKey(key, dynamicFriction);
+    appendKey(key, restitution);
+    return static_cast<PxMaterial*>(acquire(key, [&]() -> PxBase*
+    {
+        return mPhysics->createMaterial(staticFriction, dynamicFriction, restitution);
+    }));
+}
+
+PxConvexMesh* PhysicsRegistry::convexMesh(PxU64 hash, const std::function<PxConvexMesh*()>& cook)
+{
+    std::string key = "c";
+    appendKey(key, hash);
+    return static_cast<PxConvexMesh*>(acquire(key, [&]() -> PxBase* { return cook(); }));
+}
+
+PxTriangleMesh* PhysicsRegistry::triangleMesh(PxU64 hash, const std::function<PxTriangleMesh*()>& cook)
+{
+    std::string key = "t";
+    appendKey(key, hash);
+    return static_cast<PxTriangleMesh*>(acquire(key, [&]() -> PxBase* { return cook(); }));
+}
+
+PxShape* PhysicsRegistry::shape(const PxGeometry& geometry, PxMaterial* material, const PxTransform& localPose,
+                                const PxFilterData& simulationFilter)
+{
+    std::string key = "s";
+    appendKey(key, geometry.getType());
+    appendKey(key, material);
+    appendKey(key, localPose.p);
+    appendKey(key, localPose.q);
+    appendKey(key, simulationFilter);
+
+    std::vector<PxBase*> dependencies {material};
+    switch(geometry.getType())
+    {
+    case PxGeometryType::eSPHERE:
+        appendKey(key, static_cast<const PxSphereGeometry&>(geometry).radius);
+        break;
+    case PxGeometryType::eCAPSULE:
+        appendKey(key, static_cast<const PxCapsuleGeometry&>(geometry).radius);
+        appendKey(key, static_cast<const PxCapsuleGeometry&>(geometry).halfHeight);
+        break;
+    case PxGeometryType::eBOX:
+        appendKey(key, static_cast<const PxBoxGeometry&>(geometry).halfExtents);
+        break;
+    case PxGeometryType::eCONVEXMESH:
+    {
+        const PxConvexMeshGeometry& convex = static_cast<const PxConvexMeshGeometry&>(geometry);
+        appendKey(key, convex.convexMesh);
+        appendKey(key, convex.scale);
+        dependencies.push_back(convex.convexMesh);
+        break;
+    }
+    case PxGeometryType::eTRIANGLEMESH:
+    {
+        const PxTriangleMeshGeometry& mesh = static_cast<const PxTriangleMeshGeometry&>(geometry);
+        appendKey(key, mesh.triangleMesh);
+        appendKey(key, mesh.scale);
+        dependencies.push_back(mesh.triangleMesh);
+        break;
+    }
+    case PxGeometryType::eHEIGHTFIELD:
+    {
+        const PxHeightFieldGeometry& heightField = static_cast<const PxHeightFieldGeometry&>(geometry);
+        appendKey(key, heightField.heightField);
+        appendKey(key, heightField.heightScale);
+        appendKey(key, heightField.rowScale);
+        appendKey(key, heightField.columnScale);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return static_cast<PxShape*>(acquire(key, [&]() -> PxBase*
+    {
+        PxShape* shape = mPhysics->createShape(geometry, *material, false);
+        if(shape)
+        {
+            shape->setLocalPose(localPose);
+            shape->setSimulationFilterData(simulationFilter);
+        }
+        return shape;
+    }, dependencies));
+}
+
+PxBase* PhysicsRegistry::acquire(const std::string& key, const std::function<PxBase*()>& create,
+                                 const std::vector<PxBase*>& dependencies)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mEntries.find(key);
+        if(found != mEntries.end())
+        {
+            found->second.references++;
+            return found->second.object;
+        }
+    }
+
+    //Made outside the lock, cooking can take a while
+    PxBase* created = create();
+    if(!created)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto found = mEntries.find(key);
+    if(found != mEntries.end())
+    {
+        //another thread made the same thing in the meantime, use theirs
+        created->release();
+        found->second.references++;
+        return found->second.object;
+    }
+    Entry& entry = mEntries[key];
+    entry.object = created;
+    entry.references = 1;
+    for(PxBase* dependency : dependencies)
+    {
+        if(retainLocked(dependency))
+            entry.dependencies.push_back(dependency);
+    }
+    mKeys[created] = key;
+    return created;
+}
+
+void PhysicsRegistry::retain(PxBase* object)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    retainLocked(object);
+}
+
+bool PhysicsRegistry::release(PxBase* object)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return releaseLocked(object);
+}
+
+bool PhysicsRegistry::retainLocked(PxBase* object)
+{
+    auto key = mKeys.find(object);
+    if(key == mKeys.end())
+        return false;
+    mEntries[key->second].references++;
+    return true;
+}
+
+bool PhysicsRegistry::releaseLocked(PxBase* object)
+{
+    auto key = mKeys.find(object);
+    if(key == mKeys.end())
+        return false;
+    auto entry = mEntries.find(key->second);
+    if(--entry->second.references > 0)
+        return true;
+
+    std::vector<PxBase*> dependencies = entry->second.dependencies;
+    mEntries.erase(entry);
+    mKeys.erase(key);
+    //PhysX keeps the object alive for as long as shapes/actors still use it
+    object->release();
+    for(PxBase* dependency : dependencies)
+        releaseLocked(dependency);
+    return true;
+}
+
+void PhysicsRegistry::releaseShapes(PxRigidActor* actor)
+{
+    std::vector<PxShape*> shapes(actor->getNbShapes());
+    actor->getShapes(shapes.data(), static_cast<PxU32>(shapes.size()));
+    std::lock_guard<std::mutex> lock(mMutex);
+    for(PxShape* shape : shapes)
+    {
+        actor->detachShape(*shape);
+        releaseLocked(shape);
+    }
+}
+
+size_t PhysicsRegistry::size()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
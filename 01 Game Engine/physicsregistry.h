@@ -0,0 +1,60 @@
+#ifndef PHYSICSREGISTRY_H
+#define PHYSICSREGISTRY_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Shares physics resources between actors instead of making new ones for every actor:
+// - materials are interned by their parameters
+// - convex and triangle meshes by a content hash (see CookingCache::hash), so they are only cooked once
+// - shapes (non exclusive) by geometry, material and local pose, so 10k actors of one mesh share one PxShape
+//Everything handed out carries one reference for the caller, give it back with release().
+//The PhysX object is released when the last reference is gone.
+//Thread safe, meshes are looked up from the loader threads.
+class PhysicsRegistry
+{
+public:
+    void setup(PxPhysics* physics);
+
+    PxMaterial* material(PxReal staticFriction, PxReal dynamicFriction, PxReal restitution);
+    //cook is only called when the hash is not in the registry already
+    PxConvexMesh* convexMesh(PxU64 hash, const std::function<PxConvexMesh*()>& cook);
+    PxTriangleMesh* triangleMesh(PxU64 hash, const std::function<PxTriangleMesh*()>& cook);
+    //The shape keeps its own reference to the material and mesh it uses.
+    //Shapes with different filter data (e.g. contact reports on or off) are different shapes
+    PxShape* shape(const PxGeometry& geometry, PxMaterial* material, const PxTransform& localPose = PxTransform(PxIdentity),
+                   const PxFilterData& simulationFilter = PxFilterData());
+
+    void retain(PxBase* object);
+    //False if the object is not one of ours
+    bool release(PxBase* object);
+    //Detaches the actor's shapes and gives back the ones that came from the registry
+    void releaseShapes(PxRigidActor* actor);
+
+    size_t size();
+
+private:
+    struct Entry
+    {
+        PxBase* object {nullptr};
+        int references {0};
+        std::vector<PxBase*> dependencies;
+    };
+    PxBase* acquire(const std::string& key, const std::function<PxBase*()>& create,
+                    const std::vector<PxBase*>& dependencies = std::vector<PxBase*>());
+    bool retainLocked(PxBase* object);
+    bool releaseLocked(PxBase* object);
+
+    PxPhysics* mPhysics {nullptr};
+    std::unordered_map<std::string, Entry> mEntries;
+    std::unordered_map<const PxBase*, std::string> mKeys;
+    std::mutex mMutex;
+};
+
+#endif // PHYSICSREGISTRY_H
@@ -0,0 +1,438 @@
+#include "regiongrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "physicsmanager.h"
+
+namespace
+{
+//Geometry types that hold on to a mesh, which has to stay alive while it is in a StaticDesc.
+//Height fields come straight from PxCooking, so they go by PhysX's own reference count
+void retainMesh(PhysicsRegistry& registry, const PxGeometry& geometry)
+{
+    switch(geometry.getType())
+    {
+    case PxGeometryType::eCONVEXMESH: registry.retain(static_cast<const PxConvexMeshGeometry&>(geometry).convexMesh); break;
+    case PxGeometryType::eTRIANGLEMESH: registry.retain(static_cast<const PxTriangleMeshGeometry&>(geometry).triangleMesh); break;
+    case PxGeometryType::eHEIGHTFIELD: static_cast<const PxHeightFieldGeometry&>(geometry).heightField->acquireReference(); break;
+    default: break;
+    }
+}
+
+void releaseMesh(PhysicsRegistry& registry, const PxGeometry& geometry)
+{
+    switch(geometry.getType())
+    {
+    case PxGeometryType::eCONVEXMESH: registry.release(static_cast<const PxConvexMeshGeometry&>(geometry).convexMesh); break;
+    case PxGeometryType::eTRIANGLEMESH: registry.release(static_cast<const PxTriangleMeshGeometry&>(geometry).triangleMesh); break;
+    case PxGeometryType::eHEIGHTFIELD: static_cast<const PxHeightFieldGeometry&>(geometry).heightField->release(); break;
+    default: break;
+    }
+}
+}
+
+void RegionGrid::setup(PhysicsComponent* physics, PxReal regionSize, int loadRadius, PxReal border, PxReal minHeight, PxReal maxHeight)
+{
+    mPhysics = physics;
+    mRegionSize = regionSize;
+    mLoadRadius = loadRadius;
+    mBorder = border;
+    mMinHeight = minHeight;
+    mMaxHeight = maxHeight;
+}
+
+void RegionGrid::release()
+{
+    for(auto& entry : mRegions)
+    {
+        Region& region = entry.second;
+        unload(region);
+        for(PxRigidDynamic* body : region.parked)
+        {
+            mPhysics->registry().releaseShapes(body);
+            body->release();
+        }
+        for(StaticDesc& desc : region.statics)
+        {
+            mPhysics->registry().release(desc.material);
+            releaseMesh(mPhysics->registry(), desc.geometry.any());
+        }
+    }
+    mRegions.clear();
+}
+
+PxU64 RegionGrid::key(int x, int y)
+{
+    return (PxU64(PxU32(x)) << 32) | PxU32(y);
+}
+
+void RegionGrid::cell(const PxVec3& position, int& x, int& y) const
+{
+    x = static_cast<int>(std::floor(position.x / mRegionSize));
+    y = static_cast<int>(std::floor(position.y / mRegionSize));
+}
+
+RegionGrid::Region& RegionGrid::region(int x, int y)
+{
+    auto found = mRegions.find(key(x, y));
+    if(found != mRegions.end())
+        return found->second;
+    Region& region = mRegions[key(x, y)];
+    region.x = x;
+    region.y = y;
+    return region;
+}
+
+void RegionGrid::addStatic(const PxGeometry& geometry, PxMaterial* material, const PxTransform& pose, const char* name)
+{
+    if(!enabled())
+        return;
+    if(geometry.getType() == PxGeometryType::ePLANE)
+    {
+        std::cout << "planes can't go in the region grid, use a box or the terrain instead\n";
+        return;
+    }
+    const PxBounds3 bounds = PxGeometryQuery::getWorldBounds(geometry, pose, 1.f);
+    int minX, minY, maxX, maxY;
+    cell(bounds.minimum, minX, minY);
+    cell(bounds.maximum, maxX, maxY);
+    for(int x = minX; x <= maxX; x++)
+    {
+        for(int y = minY; y <= maxY; y++)
+        {
+            //every region keeps its own description (and references), so it can let go of them alone
+            Region& target = region(x, y);
+            mPhysics->registry().retain(material);
+            retainMesh(mPhysics->registry(), geometry);
+            target.statics.push_back({PxGeometryHolder(geometry), material, pose, name});
+            //Already loaded, make the actor now
+            if(target.scene)
+            {
+                if(PxRigidStatic* actor = createStatic(target, target.statics.back()))
+                    target.scene->addActor(*actor);
+            }
+        }
+    }
+}
+
+void RegionGrid::addDynamic(PxRigidDynamic* body)
+{
+    if(enabled() && body)
+        place(body);
+}
+
+void RegionGrid::forget(PxRigidDynamic* body)
+{
+    for(auto& entry : mRegions)
+    {
+        std::vector<PxRigidDynamic*>& parked = entry.second.parked;
+        parked.erase(std::remove(parked.begin(), parked.end(), body), parked.end());
+        auto ghost = entry.second.ghosts.find(body);
+        if(ghost != entry.second.ghosts.end())
+        {
+            releaseGhost(entry.second, ghost->second.actor);
+            entry.second.ghosts.erase(ghost);
+        }
+    }
+}
+
+void RegionGrid::place(PxRigidDynamic* body)
+{
+    int x, y;
+    cell(body->getGlobalPose().p, x, y);
+    Region& target = region(x, y);
+    if(target.scene)
+        target.scene->addActor(*body);
+    else
+        target.parked.push_back(body);
+}
+
+void RegionGrid::load(Region& region)
+{
+    if(region.scene)
+        return;
+    PxBounds3 bounds(PxVec3(region.x * mRegionSize, region.y * mRegionSize, mMinHeight),
+                     PxVec3((region.x + 1) * mRegionSize, (region.y + 1) * mRegionSize, mMaxHeight));
+    region.scene = mPhysics->createScene(&mPhysics->contactReporter(), bounds);
+    if(!region.scene)
+        return;
+    for(const StaticDesc& desc : region.statics)
+        createStatic(region, desc);
+    std::vector<PxActor*> actors(region.staticActors.begin(), region.staticActors.end());
+    actors.insert(actors.end(), region.parked.begin(), region.parked.end());
+    if(!actors.empty())
+        region.scene->addActors(actors.data(), static_cast<PxU32>(actors.size()));
+    region.parked.clear();
+}
+
+//The actor is only made, not added to the region's scene
+PxRigidStatic* RegionGrid::createStatic(Region& region, const StaticDesc& desc)
+{
+    //shared with every other static of the same geometry, in any region
+    PxShape* shape = mPhysics->registry().shape(desc.geometry.any(), desc.material);
+    if(!shape)
+        return nullptr;
+    PxRigidStatic* actor = mPhysics->getPhysics()->createRigidStatic(desc.pose);
+    actor->attachShape(*shape);
+    actor->setName(desc.name);
+    region.staticActors.push_back(actor);
+    return actor;
+}
+
+void RegionGrid::unload(Region& region)
+{
+    if(!region.scene)
+        return;
+    for(auto& ghost : region.ghosts)
+        releaseGhost(region, ghost.second.actor);
+    region.ghosts.clear();
+    //dynamics wait for the region to come back, statics are made again from their StaticDesc
+    mActors.resize(region.scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+    region.scene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, mActors.data(), static_cast<PxU32>(mActors.size()));
+    for(PxActor* actor : mActors)
+    {
+        region.scene->removeActor(*actor);
+        region.parked.push_back(static_cast<PxRigidDynamic*>(actor));
+    }
+    for(PxRigidStatic* actor : region.staticActors)
+    {
+        region.scene->removeActor(*actor);
+        mPhysics->registry().releaseShapes(actor);
+        actor->release();
+    }
+    region.staticActors.clear();
+    region.scene->release();
+    region.scene = nullptr;
+}
+
+void RegionGrid::update(const PxVec3& center)
+{
+    if(!enabled())
+        return;
+    int cx, cy;
+    cell(center, cx, cy);
+    for(int x = cx - mLoadRadius; x <= cx + mLoadRadius; x++)
+        for(int y = cy - mLoadRadius; y <= cy + mLoadRadius; y++)
+            load(region(x, y));
+
+    //One region of slack before unloading, so walking along a border doesn't reload every frame
+    for(auto& entry : mRegions)
+    {
+        Region& loaded = entry.second;
+        if(loaded.scene && std::max(std::abs(loaded.x - cx), std::abs(loaded.y - cy)) > mLoadRadius + 1)
+            unload(loaded);
+    }
+}
+
+void RegionGrid::simulate(PxReal dt)
+{
+    for(auto& entry : mRegions)
+    {
+        if(entry.second.scene)
+            entry.second.scene->simulate(dt);
+    }
+}
+
+void RegionGrid::fetchResults()
+{
+    if(!enabled())
+        return;
+    for(auto& entry : mRegions)
+    {
+        if(entry.second.scene)
+            entry.second.scene->fetchResults(true);
+    }
+
+    //Hand over the bodies that left their region. Collected first, place() can add regions
+    std::vector<PxRigidDynamic*> moving;
+    for(auto& entry : mRegions)
+    {
+        Region& from = entry.second;
+        if(!from.scene)
+            continue;
+        mActors.resize(from.scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+        from.scene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, mActors.data(), static_cast<PxU32>(mActors.size()));
+        for(PxActor* actor : mActors)
+        {
+            if(isGhost(actor))
+                continue;
+            PxRigidDynamic* body = static_cast<PxRigidDynamic*>(actor);
+            int x, y;
+            cell(body->getGlobalPose().p, x, y);
+            if(x == from.x && y == from.y)
+                continue;
+            from.scene->removeActor(*body, false);
+            moving.push_back(body);
+        }
+    }
+    for(PxRigidDynamic* body : moving)
+        place(body);
+    resolveGhostContacts();
+    updateGhosts();
+}
+
+void RegionGrid::updateGhosts()
+{
+    if(mBorder <= 0.f)
+        return;
+    for(auto& entry : mRegions)
+    {
+        for(auto& ghost : entry.second.ghosts)
+            ghost.second.bSeen = false;
+    }
+
+    for(auto& entry : mRegions)
+    {
+        Region& from = entry.second;
+        if(!from.scene)
+            continue;
+        mActors.resize(from.scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+        from.scene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, mActors.data(), static_cast<PxU32>(mActors.size()));
+        for(PxActor* actor : mActors)
+        {
+            if(isGhost(actor))
+                continue;
+            PxRigidDynamic* body = static_cast<PxRigidDynamic*>(actor);
+            PxBounds3 bounds = body->getWorldBounds();
+            bounds.fattenFast(mBorder);
+            int minX, minY, maxX, maxY;
+            cell(bounds.minimum, minX, minY);
+            cell(bounds.maximum, maxX, maxY);
+            for(int x = minX; x <= maxX; x++)
+            {
+                for(int y = minY; y <= maxY; y++)
+                {
+                    if(x == from.x && y == from.y)
+                        continue;
+                    auto found = mRegions.find(key(x, y));
+                    if(found == mRegions.end() || !found->second.scene)
+                        continue;
+                    Region& to = found->second;
+                    auto ghost = to.ghosts.find(body);
+                    if(ghost == to.ghosts.end())
+                    {
+                        PxRigidDynamic* copy = createGhost(body);
+                        to.scene->addActor(*copy);
+                        to.ghosts.emplace(body, Ghost{copy, true});
+                        continue;
+                    }
+                    //a sleeping body hasn't moved, and a target would keep waking what the ghost touches
+                    if(!body->isSleeping())
+                        ghost->second.actor->setKinematicTarget(body->getGlobalPose());
+                    ghost->second.bSeen = true;
+                }
+            }
+        }
+    }
+
+    //Bodies that moved away from the border, or into the region their ghost was in
+    for(auto& entry : mRegions)
+    {
+        Region& region = entry.second;
+        for(auto ghost = region.ghosts.begin(); ghost != region.ghosts.end();)
+        {
+            if(ghost->second.bSeen)
+            {
+                ++ghost;
+                continue;
+            }
+            releaseGhost(region, ghost->second.actor);
+            ghost = region.ghosts.erase(ghost);
+        }
+    }
+}
+
+//Contacts name the ghost, which updateGhosts() may release right after. Whatever reads the
+//events after the step gets the body instead
+void RegionGrid::resolveGhostContacts()
+{
+    for(ContactEvent& event : mPhysics->contactReporter().events())
+    {
+        auto ghost = mGhosts.find(event.actor0);
+        if(ghost != mGhosts.end())
+            event.actor0 = ghost->second;
+        ghost = mGhosts.find(event.actor1);
+        if(ghost != mGhosts.end())
+            event.actor1 = ghost->second;
+    }
+}
+
+//Same shapes as the body, so it collides the same. Contact reports find their way to the body's GameObject
+PxRigidDynamic* RegionGrid::createGhost(PxRigidDynamic* body)
+{
+    //not through newDynamic(), PhysX won't have CCD on a kinematic
+    PxRigidDynamic* ghost = mPhysics->getPhysics()->createRigidDynamic(body->getGlobalPose());
+    ghost->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, true);
+    std::vector<PxShape*> shapes(body->getNbShapes());
+    body->getShapes(shapes.data(), static_cast<PxU32>(shapes.size()));
+    for(PxShape* shape : shapes)
+    {
+        if(shape->isExclusive())
+            continue;
+        mPhysics->registry().retain(shape);
+        ghost->attachShape(*shape);
+    }
+    ghost->setName(body->getName());
+    ghost->userData = body->userData;
+    mGhosts.emplace(ghost, body);
+    return ghost;
+}
+
+void RegionGrid::releaseGhost(Region& region, PxRigidDynamic* ghost)
+{
+    if(region.scene)
+        region.scene->removeActor(*ghost);
+    mGhosts.erase(ghost);
+    mPhysics->registry().releaseShapes(ghost);
+    ghost->release();
+}
+
+size_t RegionGrid::loadedRegions() const
+{
+    size_t count = 0;
+    for(const auto& entry : mRegions)
+        count += entry.second.scene ? 1 : 0;
+    return count;
+}
+
+void RegionGrid::loadedScenes(std::vector<PxScene*>& scenes) const
+{
+    scenes.clear();
+    for(const auto& entry : mRegions)
+    {
+        if(entry.second.scene)
+            scenes.push_back(entry.second.scene);
+    }
+}
+
+void RegionGrid::dynamics(std::vector<PxRigidDynamic*>& bodies, bool bParked) const
+{
+    bodies.clear();
+    std::vector<PxActor*> actors;
+    for(const auto& entry : mRegions)
+    {
+        const Region& region = entry.second;
+        if(bParked)
+            bodies.insert(bodies.end(), region.parked.begin(), region.parked.end());
+        if(!region.scene)
+            continue;
+        actors.resize(region.scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+        region.scene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, actors.data(), static_cast<PxU32>(actors.size()));
+        for(PxActor* actor : actors)
+        {
+            if(!isGhost(actor))
+                bodies.push_back(static_cast<PxRigidDynamic*>(actor));
+        }
+    }
+}
+
+PxScene* RegionGrid::sceneAt(const PxVec3& position)
+{
+    if(!enabled())
+        return nullptr;
+    int x, y;
+    cell(position, x, y);
+    auto found = mRegions.find(key(x, y));
+    return found != mRegions.end() ? found->second.scene : nullptr;
+}
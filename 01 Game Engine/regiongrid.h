@@ -0,0 +1,104 @@
+#ifndef REGIONGRID_H
+#define REGIONGRID_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+class PhysicsComponent;
+
+//Splits a big world into square regions along X and Y, each its own PxScene. Only the
+//regions around the player are loaded. They share PxPhysics, the dispatcher and the shapes
+//from the registry, and they all simulate at the same time so the regions run in parallel.
+//Dynamics that cross into another region are moved over after every step. A dynamic whose
+//region is not loaded waits (parked) until it is.
+//Bodies closer than border to a neighbouring region get a kinematic ghost in it, with the same
+//shapes, following the body one step behind. Bodies on either side of a border collide with each
+//other's ghost, which is close but not the same as one scene: a ghost has no mass, so it pushes
+//like a moving wall and is never pushed back.
+//Region scenes report contacts to the main scene's ContactReporter, one after another in
+//fetchResults(). A contact across a border is reported from both sides, against the other's ghost.
+class RegionGrid
+{
+public:
+    //regionSize 0 turns the grid off. loadRadius is in regions, 1 loads the 3x3 around the player
+    void setup(PhysicsComponent* physics, PxReal regionSize, int loadRadius, PxReal border, PxReal minHeight, PxReal maxHeight);
+    //Releases every region and everything in them
+    void release();
+    bool enabled() const {return mRegionSize > 0.f;}
+
+    //World content that never moves, turned into actors whenever a region it overlaps loads.
+    //Big statics (terrain) go into every region their bounds touch. Planes have no bounds and are
+    //not accepted. Takes its own reference to the material and any mesh in the geometry
+    void addStatic(const PxGeometry& geometry, PxMaterial* material, const PxTransform& pose, const char* name = nullptr);
+    //Goes into the region it is in. The grid owns the body from now on
+    void addDynamic(PxRigidDynamic* body);
+    //The body is being released, take it out of any parked list and let go of its ghosts
+    void forget(PxRigidDynamic* body);
+    //Ghosts are in the region scenes like any other dynamic, anything walking those scenes skips them
+    bool isGhost(const PxActor* actor) const {return mGhosts.count(actor) > 0;}
+
+    //Loads and unloads regions around the player
+    void update(const PxVec3& center);
+    //Starts every loaded region, does not wait
+    void simulate(PxReal dt);
+    //Waits for all of them, then hands bodies over to the region they ended up in
+    void fetchResults();
+
+    size_t loadedRegions() const;
+    void loadedScenes(std::vector<PxScene*>& scenes) const;
+    //Every body the grid holds (not the ghosts), bParked also gives the ones waiting for their region
+    void dynamics(std::vector<PxRigidDynamic*>& bodies, bool bParked) const;
+    PxScene* sceneAt(const PxVec3& position);
+
+private:
+    struct StaticDesc
+    {
+        PxGeometryHolder geometry;
+        PxMaterial* material;
+        PxTransform pose;
+        const char* name;
+    };
+    struct Ghost
+    {
+        PxRigidDynamic* actor;
+        bool bSeen;     //still near the border this step
+    };
+    struct Region
+    {
+        int x {0};
+        int y {0};
+        PxScene* scene {nullptr};
+        std::vector<StaticDesc> statics;
+        std::vector<PxRigidStatic*> staticActors;
+        std::vector<PxRigidDynamic*> parked;    //waiting for the region to load
+        std::unordered_map<PxRigidDynamic*, Ghost> ghosts;     //by the body in the neighbour
+    };
+
+    static PxU64 key(int x, int y);
+    void cell(const PxVec3& position, int& x, int& y) const;
+    Region& region(int x, int y);
+    void load(Region& region);
+    void unload(Region& region);
+    PxRigidStatic* createStatic(Region& region, const StaticDesc& desc);
+    void place(PxRigidDynamic* body);
+    void updateGhosts();
+    void resolveGhostContacts();
+    PxRigidDynamic* createGhost(PxRigidDynamic* body);
+    void releaseGhost(Region& region, PxRigidDynamic* ghost);
+
+    PhysicsComponent* mPhysics {nullptr};
+    PxReal mRegionSize {0.f};
+    int mLoadRadius {1};
+    PxReal mBorder {0.f};
+    PxReal mMinHeight {0.f};
+    PxReal mMaxHeight {0.f};
+    std::unordered_map<PxU64, Region> mRegions;
+    std::unordered_map<const PxActor*, PxRigidDynamic*> mGhosts;  //ghost to its body
+    std::vector<PxActor*> mActors;      //scratch for scanning scenes
+};
+
+#endif // REGIONGRID_H
@@ -10,6 +10,8 @@
 
 #include <string>
 #include <unordered_map>
+#include <fstream>
+#include <iterator>
 
 #include "visualobject.h"
 #include "camera.h"
@@ -18,13 +20,34 @@
 #include "logger.h"
 #include "texture.h"
 #include "light.h"
-#include "trianglesurface.h"
 #include "objectmesh.h"
 #include "soundcomponent.h"
+#include "audioengine.h"
+#include "soundcache.h"
+#include "audiostream.h"
 #include "gameobject.h"
 #include "graphicscomponent.h"
 #include "inputcomponent.h"
 #include "dialoguecontroller.h"
+#include "assetmanager.h"
+#include "hotreloader.h"
+#include "physicsdebugrenderer.h"
+
+namespace
+{
+//Everything a GameObject needs that can be prepared on a worker thread
+struct ObjectLoad
+{
+    GraphicsComponent* graphics {nullptr};
+    CollisionProxy collision;
+};
+
+struct TerrainLoad
+{
+    GraphicsComponent* graphics {nullptr};
+    TerrainShape collision;
+};
+}
 
 RenderWindow::RenderWindow(const QSurfaceFormat &format, MainWindow *mainWindow)
     : mContext(nullptr), mInitialized(false), mMainWindow(mainWindow)
@@ -56,6 +79,10 @@ RenderWindow::~RenderWindow()
     glDeleteBuffers( 1, &mVBO );
     //Stop doing Lua stuff
     lua_close(L);
+    delete mSound;
+    delete mMusic;
+    SoundCache::getInstance()->clear();
+    AudioEngine::getInstance()->release();
 }
 
 // Sets up the general OpenGL stuff and the buffers needed to render a Cube
@@ -84,7 +111,13 @@ void RenderWindow::init()
 
     //must call this to use OpenGL functions
     initializeOpenGLFunctions();
-        Phys.initPhysics();
+    //PVD is off by default, set config.pvdTransport to Socket or File to capture
+    PhysicsConfig physicsConfig;
+    PhysicsConfig::fromLua("../GEA2022/physics.lua", physicsConfig);
+    Phys.initPhysics(physicsConfig);
+    mLevelKey = physicsConfig.buildKey();
+    mPhysicsDebug = new PhysicsDebugRenderer;
+    mPhysicsDebug->init();
     //Print render version info (what GPU is used):
     //Nice to see if you use the Intel GPU or the dedicated GPU on your laptop
     // - can be deleted
@@ -124,12 +157,15 @@ void RenderWindow::init()
     //NB: hardcoded path to files! You have to change this if you change directories for the project.
     //Qt makes a build-folder besides the project folder. That is why we go down one directory
     // (out of the build-folder) and then up into the project folder.
-    mShaders.push_back(new Shader("../GEA2022/plainshader.vert", "../GEA2022/plainshader.frag"));
-    mLogger->logText("Plain shader program id: " + std::to_string(mShaders.back()->getProgram()) );
-    mShaders.push_back(new Shader("../GEA2022/textureshader.vert", "../GEA2022/textureshader.frag"));
-    mLogger->logText("Texture shader program id: " + std::to_string(mShaders.back()->getProgram()) );
-    mShaders.push_back( new Shader("../GEA2022/phongshader.vert", "../GEA2022/phongshader.frag"));
-    mLogger->logText("Texture shader program id: " + std::to_string(mShaders.back()->getProgram()) );
+    //The file names are kept so the shaders can be hot reloaded
+    mShaderFiles.push_back({"../GEA2022/plainshader.vert", "../GEA2022/plainshader.frag"});
+    mShaderFiles.push_back({"../GEA2022/textureshader.vert", "../GEA2022/textureshader.frag"});
+    mShaderFiles.push_back({"../GEA2022/phongshader.vert", "../GEA2022/phongshader.frag"});
+    for(auto& files : mShaderFiles)
+    {
+        mShaders.push_back(new Shader(files.first.c_str(), files.second.c_str()));
+        mLogger->logText(files.first + " shader program id: " + std::to_string(mShaders.back()->getProgram()) );
+    }
 
     for(unsigned int i = 0; i < mShaders.size(); i++)
     setupShader(i);
@@ -138,7 +174,7 @@ void RenderWindow::init()
     //Returns a pointer to the Texture class. This reads and sets up the texture for OpenGL
     //and returns the Texture ID that OpenGL uses from Texture::id()
     mTextures.push_back(new Texture);
-    mTextures.push_back(new Texture("../GEA2022/assets/grass.bmp"));
+    mTextures.push_back(new Texture("../GEA2022/assets/grass.bmp"));     //also hot reloaded, see below
 
     //Set the textures loaded to a texture unit (also called a texture slot)
     glActiveTexture(GL_TEXTURE0);
@@ -150,12 +186,73 @@ void RenderWindow::init()
     mMMatrix->setToIdentity();    //1, 1, 1, 1 in the diagonal of the matrix
 
     mCamera = new Camera();
-    mSound = new SoundComponent("../GEA2022/Assets/laser.wav", {pos.x(), pos.y(), pos.z()}, {0,0,0});
 
-    VisualObject* temp;
+    //Everything below is loaded in the background and shows up when it is ready.
+    //The parsing/decoding/cooking runs on the JobSystem, the GL and PhysX scene parts
+    //are finished in render() through mAssets->update()
+    mAssets = AssetManager::getInstance();
+    //One OpenAL device for everything, has to be there before the first SoundComponent
+    AudioEngine::getInstance()->setup();
+    //the SoundCache decodes it in the background, playing before that does nothing
+    mSound = new SoundComponent("../GEA2022/Assets/laser.wav", pos, QVector3D(0,0,0));
+    const std::string scriptFile = "../GEA2022/init.lua";
+    const std::string terrainFile = "../GEA2022/assets/terrain.txt";
+    const std::string testMeshFile = "../GEA2022/assets/test.obj";
+    const std::string grassFile = "../GEA2022/assets/grass.bmp";
+    mLevelSources = {terrainFile, testMeshFile};
+    mLevelFile = SceneSerializer::stamped(mLevelBase, mLevelSources, mLevelKey);
+    bLevelFromFile = Phys.importScene(mLevelFile);
+    loadScript(scriptFile);
+    loadTerrain(terrainFile);
+
+    //Creating a Game Object
+    loadGameObject("testObject", "test", testMeshFile, "../GEA2022/Assets/laser.wav", QVector3D(0,0,10), 0);
+
+    //Hot reloading: edit any of these files while the game is running
+    mHotReloader = new HotReloader;
+    for(unsigned int i = 0; i < mShaderFiles.size(); i++)
+    {
+        mHotReloader->watch(mShaderFiles[i].first, [this, i](){ reloadShader(i); });
+        mHotReloader->watch(mShaderFiles[i].second, [this, i](){ reloadShader(i); });
+    }
+    mHotReloader->watch(grassFile, [this, grassFile](){ reloadTexture(1, grassFile); });
+    mHotReloader->watch(scriptFile, [this, scriptFile](){ loadScript(scriptFile); });
+    mHotReloader->watch(terrainFile, [this, terrainFile](){ reloadTerrain(terrainFile); });
+    mHotReloader->watch(testMeshFile, [this, testMeshFile](){ reloadMesh("testObject", testMeshFile); });
+
+    //Phys.helloWorldSnippets();
+
+    mLight = new Light(mShaders[0]->getProgram(), mTextures[0]->id());
+    mLight->setName("light");
+    mLight->mMatrix.translate(1.f, 1.f, 1.f);
+    mObjects.push_back(mLight);
+
+    aspectratio = static_cast<float>(width()) / height();
+    mCamera->init();
+    mCamera->perspective(60.f, aspectratio, 0.1f, 400.f);
+
+    glBindVertexArray(0);       //unbinds any VertexArray - good practice
+    TestDia = DialogueController::getInstance();
+}
 
-    if(CheckLua(L, luaL_dofile(L, "../GEA2022/init.lua")))
+void RenderWindow::loadScript(std::string fileName)
+{
+    mAssets->load<std::string>([fileName]() -> std::string*
+    {
+        std::ifstream fileIn(fileName);
+        if(!fileIn)
+            return nullptr;
+        return new std::string(std::istreambuf_iterator<char>(fileIn), std::istreambuf_iterator<char>());
+    },
+    [this](std::string* script)
     {
+        //lua_State is not thread safe, so the script itself is run here on the GUI thread
+        bool bLoaded = CheckLua(L, luaL_loadbuffer(L, script->data(), script->size(), "init.lua")) &&
+                       CheckLua(L, lua_pcall(L, 0, LUA_MULTRET, 0));
+        delete script;
+        if(!bLoaded)
+            return false;
+
         lua_getglobal(L, "GetObject");
         if (lua_isfunction(L, -1))
         {
@@ -166,67 +263,270 @@ void RenderWindow::init()
                 lua_pushstring(L, "FilePath");
                 lua_gettable(L, -2);
                 qDebug() << "[Lua] has found " << lua_tostring(L, -1) << "/n";
-                temp = new ObjectMesh(lua_tostring(L, -1), mShaders[0]->getProgram(), mTextures[0]->id());
-                lua_pop(L, 1);
-                //need to delete something here? memory leak from "new"
+                lua_pop(L, 2);  //the path and the table it came from
             }
-
+            else
+                lua_pop(L, 1);  //the error message
         }
-    }
-
-    surface = new TriangleSurface("../GEA2022/assets/terrain.txt",
-                                  mShaders[2]->getProgram(), mTextures[1]->id(),Phys.getPhysics(),Phys.getScene(),Phys.getCooking(),"Terrain");
-    surface->init(mMMatrixUniform[2]);
-
-    //Creating a Game Object
-            GameObject* testObject = new GameObject(new InputComponent(),
-                    new SoundComponent("../GEA2022/Assets/laser.wav", {pos.x(), pos.y(), pos.z()}, {0,0,0}),
-                    new GraphicsComponent("../GEA2022/assets/test.obj", mShaders[0]->getProgram(), mTextures[0]->id()),
-                    "test",
-                    QVector3D(0,0,10));
-    testObject->mMatrix.setColumn(3,QVector3D(0,0,10).toVector4D());
-    Phys.createDynamic(testObject,testObject->name,PxTransform(PxVec3(testObject->graphics()->mMatrix.column(3).x(),testObject->graphics()->mMatrix.column(3).y(),testObject->graphics()->mMatrix.column(3).z())),
-                       Phys.getPhysics(),Phys.getCooking(),Phys.getScene());
+        else
+            lua_pop(L, 1);
 
-    //Phys.helloWorldSnippets();
+        //Music = "file.wav" streams it in a loop, changing it in the script swaps the track on reload
+        lua_getglobal(L, "Music");
+        if(lua_isstring(L, -1))
+        {
+            if(!mMusic)
+                mMusic = new AudioStream;
+            mMusic->open(lua_tostring(L, -1));
+        }
+        else if(mMusic)
+            mMusic->close();
+        lua_pop(L, 1);
+        return true;
+    });
+}
 
-    mGameObjects.insert(std::pair("testObject", testObject));
-    mLight = new Light(mShaders[0]->getProgram(), mTextures[0]->id());
-    mLight->setName("light");
-    mLight->mMatrix.translate(1.f, 1.f, 1.f);
-    mObjects.push_back(mLight);
+void RenderWindow::loadTerrain(std::string fileName)
+{
+    GLuint shaderId = mShaders[2]->getProgram();
+    GLuint textureId = mTextures[1]->id();
+    mAssets->load<TerrainLoad>([this, fileName, shaderId, textureId]()
+    {
+        TerrainLoad* load = new TerrainLoad;
+        load->graphics = new GraphicsComponent(fileName, shaderId, textureId);
+        if(!bLevelFromFile)
+            load->collision = Phys.cookTerrain(load->graphics->getVertices(), load->graphics->getIndices());
+        return load;
+    },
+    [this](TerrainLoad* load)
+    {
+        mTerrain = new GameObject(nullptr, nullptr, load->graphics, "Terrain", QVector3D(0,0,0));
+        if(!bShader)
+            load->graphics->setShaderId(mShaders[0]->getProgram());
+        load->graphics->init(mMMatrixUniform[bShader ? 2 : 0]);
+        if(!Phys.linkActor(mTerrain->name, PxTransform(PxIdentity)))
+        {
+            //not in the level file after all
+            if(!load->collision.valid())
+                load->collision = Phys.cookTerrain(load->graphics->getVertices(), load->graphics->getIndices());
+            Phys.addTerrain(load->collision, mTerrain->name);
+        }
+        mGameObjects.insert(std::pair("terrain", mTerrain));
+        delete load;
+        return true;
+    });
+}
 
-    aspectratio = static_cast<float>(width()) / height();
-    mCamera->init();
-    mCamera->perspective(60.f, aspectratio, 0.1f, 400.f);
+void RenderWindow::loadGameObject(std::string key, const char* name, std::string meshFile, std::string soundFile,
+                                  QVector3D position, int shaderIndex)
+{
+    GLuint shaderId = mShaders[shaderIndex]->getProgram();
+    GLuint textureId = mTextures[0]->id();
+    mAssets->load<ObjectLoad>([this, meshFile, shaderId, textureId]()
+    {
+        ObjectLoad* load = new ObjectLoad;
+        load->graphics = new GraphicsComponent(meshFile, shaderId, textureId);
+        if(!bLevelFromFile)
+            load->collision = Phys.buildProxy(load->graphics->getVertices(), load->graphics->getIndices());
+        return load;
+    },
+    [this, key, name, position, shaderIndex, soundFile](ObjectLoad* load)
+    {
+        //sounds are shared through the SoundCache, so they are not part of the worker step
+        SoundComponent* sound = nullptr;
+        if(!soundFile.empty())
+            sound = new SoundComponent(soundFile.c_str(), pos, QVector3D(0,0,0));
+        GameObject* object = new GameObject(new InputComponent(), sound, load->graphics, name, position);
+        object->mMatrix.setColumn(3, position.toVector4D());
+        load->graphics->init(mMMatrixUniform[shaderIndex]);
+        const PxTransform spawn(PxVec3(position.x(), position.y(), position.z()));
+        PxRigidActor* actor = Phys.linkActor(object->name, spawn);
+        if(!actor)
+        {
+            if(!load->collision.valid())
+                load->collision = Phys.buildProxy(load->graphics->getVertices(), load->graphics->getIndices());
+            actor = Phys.addDynamic(load->collision, object->name, spawn);
+        }
+        if(actor)
+        {
+            //so contact events can find their way back to the object
+            actor->userData = object;
+            Phys.setContactReports(actor, sound != nullptr);
+        }
+        mGameObjects.insert(std::pair(key, object));
+        delete load;
+        return true;
+    });
+}
 
+void RenderWindow::handleContacts()
+{
+    const std::vector<ContactEvent>& contacts = Phys.contacts();
+    if(contacts.empty())
+        return;
 
-    for(auto it : mGameObjects)
+    //Impact sounds
+    for(const ContactEvent& contact : contacts)
     {
-        if (it.second->graphics()->getShaderId()==mShaders[1]->getProgram())
+        if(contact.type != ContactEvent::Type::Contact || contact.impulse < mImpactImpulse)
+            continue;
+        for(PxRigidActor* actor : {contact.actor0, contact.actor1})
         {
-            it.second->graphics()->init(mMMatrixUniform[1]);
+            GameObject* object = actor ? static_cast<GameObject*>(actor->userData) : nullptr;
+            if(object && object->sound())
+                object->sound()->playMono(QVector3D(contact.position.x, contact.position.y, contact.position.z));
         }
-        else if(it.second->graphics()->getShaderId()==mShaders[2]->getProgram())
+    }
+
+    //Lua gets all of them in one call: OnContact({ {A=, B=, Type=, Impulse=, X=, Y=, Z=}, ... })
+    lua_getglobal(L, "OnContact");
+    if(!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        return;
+    }
+    static const char* typeNames[] = {"Contact", "TriggerEnter", "TriggerExit"};
+    lua_createtable(L, static_cast<int>(contacts.size()), 0);
+    for(size_t i = 0; i < contacts.size(); i++)
+    {
+        const ContactEvent& contact = contacts[i];
+        lua_createtable(L, 0, 7);
+        lua_pushstring(L, contact.actor0 && contact.actor0->getName() ? contact.actor0->getName() : "");
+        lua_setfield(L, -2, "A");
+        lua_pushstring(L, contact.actor1 && contact.actor1->getName() ? contact.actor1->getName() : "");
+        lua_setfield(L, -2, "B");
+        lua_pushstring(L, typeNames[static_cast<int>(contact.type)]);
+        lua_setfield(L, -2, "Type");
+        lua_pushnumber(L, contact.impulse);
+        lua_setfield(L, -2, "Impulse");
+        lua_pushnumber(L, contact.position.x);
+        lua_setfield(L, -2, "X");
+        lua_pushnumber(L, contact.position.y);
+        lua_setfield(L, -2, "Y");
+        lua_pushnumber(L, contact.position.z);
+        lua_setfield(L, -2, "Z");
+        lua_rawseti(L, -2, static_cast<int>(i + 1));
+    }
+    if(!CheckLua(L, lua_pcall(L, 1, 0, 0)))
+        lua_pop(L, 1);  //the error message, this runs every frame
+}
+
+void RenderWindow::reloadMesh(std::string key, std::string meshFile)
+{
+    auto found = mGameObjects.find(key);
+    if(found == mGameObjects.end())     //not done loading the first time yet
+        return;
+    GLuint shaderId = found->second->graphics()->getShaderId();
+    GLuint textureId = found->second->graphics()->getTexId();
+    mAssets->load<ObjectLoad>([this, meshFile, shaderId, textureId]()
+    {
+        ObjectLoad* load = new ObjectLoad;
+        load->graphics = new GraphicsComponent(meshFile, shaderId, textureId);
+        load->collision = Phys.buildProxy(load->graphics->getVertices(), load->graphics->getIndices());
+        return load;
+    },
+    [this, key, meshFile](ObjectLoad* load)
+    {
+        auto found = mGameObjects.find(key);
+        bool bFound = found != mGameObjects.end();
+        if(bFound)
         {
-            it.second->graphics()->init(mMMatrixUniform[2]);
+            GameObject* object = found->second;
+            object->graphics()->reload(*load->graphics);
+            if(load->collision.valid())
+                Phys.replaceCollision(Phys.findActor(object->name), load->collision.geometry().any(), load->collision.localPose);
+            mLogger->logText("Reloaded " + meshFile);
         }
         else
+            Phys.registry().release(load->collision.hull);
+        delete load->graphics;
+        delete load;
+        return bFound;
+    });
+}
+
+void RenderWindow::reloadTerrain(std::string fileName)
+{
+    if(!mTerrain)
+        return;
+    GLuint shaderId = mTerrain->graphics()->getShaderId();
+    GLuint textureId = mTerrain->graphics()->getTexId();
+    mAssets->load<TerrainLoad>([this, fileName, shaderId, textureId]()
+    {
+        TerrainLoad* load = new TerrainLoad;
+        load->graphics = new GraphicsComponent(fileName, shaderId, textureId);
+        load->collision = Phys.cookTerrain(load->graphics->getVertices(), load->graphics->getIndices());
+        return load;
+    },
+    [this, fileName](TerrainLoad* load)
+    {
+        mTerrain->graphics()->reload(*load->graphics);
+        if(load->collision.valid())
+            Phys.replaceCollision(Phys.findActor(mTerrain->name), load->collision.geometry().any(), load->collision.localPose);
+        mLogger->logText("Reloaded " + fileName);
+        delete load->graphics;
+        delete load;
+        return true;
+    });
+}
+
+void RenderWindow::reloadShader(unsigned int index)
+{
+    Shader* shader = new Shader(mShaderFiles[index].first.c_str(), mShaderFiles[index].second.c_str());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(shader->getProgram(), GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE)
+    {
+        //keep running with the old program until the shader compiles again
+        mLogger->logText("Reload of " + mShaderFiles[index].first + " failed", LogType::REALERROR);
+        delete shader;
+        return;
+    }
+
+    GLuint oldProgram = mShaders[index]->getProgram();
+    delete mShaders[index];
+    mShaders[index] = shader;
+    setupShader(index);
+    for(auto& it : mGameObjects)
+    {
+        if(it.second->graphics()->getShaderId() == oldProgram)
         {
-            it.second->graphics()->init(mMMatrixUniform[0]);
+            it.second->graphics()->setShaderId(shader->getProgram());
+            it.second->graphics()->setMatrixUniform(mMMatrixUniform[index]);
         }
     }
+    mLogger->logText("Reloaded " + mShaderFiles[index].first + ", new program id: " + std::to_string(shader->getProgram()));
+}
 
-    glBindVertexArray(0);       //unbinds any VertexArray - good practice
-    TestDia = DialogueController::getInstance();
+void RenderWindow::reloadTexture(unsigned int index, std::string fileName)
+{
+    Texture* texture = new Texture(fileName.c_str());
+    GLuint oldId = mTextures[index]->id();
+    for(auto& it : mGameObjects)
+    {
+        if(it.second->graphics()->getTexId() == oldId)
+            it.second->graphics()->setTextureId(texture->id());
+    }
+    delete mTextures[index];
+    mTextures[index] = texture;
+    glActiveTexture(GL_TEXTURE0 + index);
+    glBindTexture(GL_TEXTURE_2D, texture->id());
+    mLogger->logText("Reloaded " + fileName);
 }
 
 void RenderWindow::setupShader(int index)
 {
     {
-        mMMatrixUniform.push_back(glGetUniformLocation(mShaders[index]->getProgram(), "mMatrix"));
-        mVMatrixUniform.push_back(glGetUniformLocation(mShaders[index]->getProgram(), "vMatrix"));
-        mPMatrixUniform.push_back(glGetUniformLocation(mShaders[index]->getProgram(), "pMatrix"));
+        //Hot reloaded shaders overwrite their old uniform locations
+        if(static_cast<int>(mMMatrixUniform.size()) <= index)
+        {
+            mMMatrixUniform.resize(index + 1);
+            mVMatrixUniform.resize(index + 1);
+            mPMatrixUniform.resize(index + 1);
+        }
+        mMMatrixUniform[index] = glGetUniformLocation(mShaders[index]->getProgram(), "mMatrix");
+        mVMatrixUniform[index] = glGetUniformLocation(mShaders[index]->getProgram(), "vMatrix");
+        mPMatrixUniform[index] = glGetUniformLocation(mShaders[index]->getProgram(), "pMatrix");
         if(index == 1)
             mTextureUniform = glGetUniformLocation(mShaders[index]->getProgram(), "textureSampler");
         if(index == 2)
@@ -252,10 +552,17 @@ void RenderWindow::render()
 
     initializeOpenGLFunctions();    //must call this every frame it seems...
 
+    //start reloads for changed asset files, then finish whatever the
+    //background loaders have ready, within the frame budget
+    mHotReloader->update();
+    mAssets->update(mAssetBudgetNs);
+
     //clear the screen for each redraw
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    Phys.setActivityCenter(PxVec3(pos.x(), pos.y(), pos.z()));
     Phys.simulationStep(dt);
+    handleContacts();
 
     moveCamera(); //Move to Input component?
 
@@ -268,30 +575,19 @@ void RenderWindow::render()
         }
         it.second->mMatrix = it.second->mPosition;
          Phys.update(it.second);
-        //it.second->sound.update();
+        //the AudioEngine ranks voices by distance, so they have to be where the object is
+        if(it.second->sound())
+            it.second->sound()->setPosition(it.second->mMatrix.column(3).toVector3D());
         it.second->graphics()->update(it.second->mMatrix, mVMatrixUniform, mPMatrixUniform, mShaders, mCamera, mLight);
     }
-    if (surface)
+    if (Phys.debugDraw())
     {
-        if (bShader)
-        {
-            glUseProgram(mShaders[2]->getProgram());
-            glUniformMatrix4fv(mVMatrixUniform[2], 1, GL_FALSE, mCamera->mVMatrix.constData());
-            glUniformMatrix4fv(mPMatrixUniform[2], 1, GL_FALSE, mCamera->mPMatrix.constData());
-            glUniform3f(mLightPositionUniform, mLight->mMatrix.column(3).x(), mLight->mMatrix.column(3).y(), mLight->mMatrix.column(3).z());
-            glUniform3f(mCameraPositionUniform, mCamera->position().x(), mCamera->position().y(), mCamera->position().z());
-            glUniform3f(mLightColorUniform, mLight->mLightColor.x(), mLight->mLightColor.y(), mLight->mLightColor.z());
-            glUniform1f(mSpecularStrengthUniform, mLight->mSpecularStrength);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, (surface->getTexId()));
-        }
-        else
-        {
-            glUseProgram(mShaders[0]->getProgram());
-            glUniformMatrix4fv(mVMatrixUniform[0], 1, GL_FALSE, mCamera->mVMatrix.constData());
-            glUniformMatrix4fv(mPMatrixUniform[0], 1, GL_FALSE, mCamera->mPMatrix.constData());
-        }
-        surface->draw();
+        glUseProgram(mShaders[0]->getProgram());
+        glUniformMatrix4fv(mVMatrixUniform[0], 1, GL_FALSE, mCamera->mVMatrix.constData());
+        glUniformMatrix4fv(mPMatrixUniform[0], 1, GL_FALSE, mCamera->mPMatrix.constData());
+        mPhysicsDebug->draw(Phys.getScene()->getRenderBuffer(), mMMatrixUniform[0]);
+        for(PxScene* scene : Phys.regionScenes())
+            mPhysicsDebug->draw(scene->getRenderBuffer(), mMMatrixUniform[0]);
     }
     static float rotate{0.f};
     mLight->mMatrix.translate(sinf(rotate)/10, cosf(rotate)/10, cosf(rotate)/60);//Move to Input component
@@ -438,15 +734,17 @@ bool RenderWindow::CheckLua(lua_State *L, int r)
 void RenderWindow::shaderToggle()
 {
     bShader = !bShader;
+    if(!mTerrain)   //still loading, picks up bShader when it is done
+        return;
     if(bShader)
     {
-        surface->shaderToggle(mShaders[2]->getProgram());
-        surface->init(mMMatrixUniform[2]);
+        mTerrain->graphics()->setShaderId(mShaders[2]->getProgram());
+        mTerrain->graphics()->init(mMMatrixUniform[2]);
     }
     else
     {
-        surface->shaderToggle(mShaders[0]->getProgram());
-        surface->init(mMMatrixUniform[0]);
+        mTerrain->graphics()->setShaderId(mShaders[0]->getProgram());
+        mTerrain->graphics()->init(mMMatrixUniform[0]);
     }
 }
 
@@ -486,7 +784,8 @@ void RenderWindow::moveCamera()
             mCamera->translate(0.f, 0.f, d*2);
             pos.setZ(pos.z() + d*2);
         }
-    mSound->setListener(pos.x(),pos.y(),pos.z());
+    if(mSound)
+        mSound->setListener(pos.x(),pos.y(),pos.z());
     }
 }
 
@@ -523,10 +822,14 @@ void RenderWindow::keyPressEvent(QKeyEvent *event)
         mInput.E = true;
     }
 
-    if(event->key() == Qt::Key_Space)
+    if(event->key() == Qt::Key_Space && mSound)
     {
         mSound->playMono();
     }
+    if(event->key() == Qt::Key_P)
+    {
+        Phys.setDebugDraw(!Phys.debugDraw());
+    }
     if(event->key() == Qt::Key_I)
     {
         TestDia->AdvanceDialogueA();
@@ -535,6 +838,27 @@ void RenderWindow::keyPressEvent(QKeyEvent *event)
     {
         TestDia->AdvanceDialogueB();
     }
+    if(event->key() == Qt::Key_F5)
+    {
+        //stamped again, the hot reloader may have changed the assets since start
+        mLevelFile = SceneSerializer::stamped(mLevelBase, mLevelSources, mLevelKey);
+        if(Phys.exportScene(mLevelFile))
+            mLogger->logText("Physics saved to " + mLevelFile);
+    }
+    //The slowest recorded step, for physicsbenchmark --replay
+    //The snapshot before the slow step is saved, along with how many steps after it the slow one came,
+    //so the replay steps up to it first and then measures the step itself
+    if(event->key() == Qt::Key_F6 && Phys.recorder().size() > 1)
+    {
+        PhysicsRecorder& recorder = Phys.recorder();
+        size_t slowest = recorder.slowest();
+        if(Phys.exportSnapshot(slowest - 1, mSpikeFile))
+        {
+            std::ofstream(mSpikeFile + ".steps") << recorder.slowOffsetOf(slowest);
+            mLogger->logText("Physics step " + std::to_string(recorder.stepOf(slowest - 1) + recorder.slowOffsetOf(slowest) + 1) + " (" +
+                             std::to_string(recorder.stepMsOf(slowest)) + " ms) saved to " + mSpikeFile);
+        }
+    }
 }
 
 void RenderWindow::keyReleaseEvent(QKeyEvent *event)
@@ -6,6 +6,7 @@
 #include <QTimer>
 #include <QElapsedTimer>
 #include <vector>
+#include <string>
 #include <QVector3D>
 #include "input.h"
 #include "al.h"
@@ -31,11 +32,13 @@ class MainWindow;
 class Logger;
 class Texture;
 class Light;
-class TriangleSurface;
 class ObjectMesh;
 class SoundComponent;
 class GameObject;
 class DialogueController;
+class AssetManager;
+class HotReloader;
+class PhysicsDebugRenderer;
 
 /// This inherits from QWindow to get access to the Qt functionality and
 // OpenGL surface.
@@ -63,24 +66,54 @@ private slots:
 
 private:
     PhysicsComponent Phys;
+    PhysicsDebugRenderer* mPhysicsDebug {nullptr};     //toggled with P
 
 private:
     std::vector<VisualObject*> mObjects;                        //Standard container
     std::unordered_map<std::string, GameObject*> mGameObjects;  //Hash container for game objects
 
-    TriangleSurface* surface {nullptr};
+    GameObject* mTerrain {nullptr};
     Input mInput;
     Camera* mCamera {nullptr};
     SoundComponent* mSound{nullptr};
+    class AudioStream* mMusic{nullptr};     //the Music file from init.lua
     float aspectratio = 1.f;
     bool bCameraLock {false};
 
     void init();            //initialize things we need before rendering
 
+    //Background loading, see AssetManager
+    AssetManager* mAssets {nullptr};
+    qint64 mAssetBudgetNs {4000000};    //time pr frame we allow for finishing loaded assets (4ms)
+    //Physics saved with F5, loaded at start instead of cooking and building every actor.
+    //The real name carries a hash of the assets it was built from, see SceneSerializer::stamped()
+    const std::string mLevelBase {"../GEA2022/cache/level.pxb"};
+    std::string mLevelFile;
+    std::vector<std::string> mLevelSources;
+    std::string mLevelKey;              //PhysicsConfig::buildKey() of the config we started with
+    const std::string mSpikeFile {"../GEA2022/cache/spike.pxb"};
+    bool bLevelFromFile {false};
+    void loadScript(std::string fileName);
+    void loadTerrain(std::string fileName);
+    void loadGameObject(std::string key, const char* name, std::string meshFile, std::string soundFile,
+                        QVector3D position, int shaderIndex);
+
+    //Reacting to the contact events of the last physics step, see ContactReporter
+    float mImpactImpulse {1.f};     //weaker hits than this don't make a sound
+    void handleContacts();
+
+    //Hot reloading of changed files, see HotReloader
+    HotReloader* mHotReloader {nullptr};
+    void reloadMesh(std::string key, std::string meshFile);
+    void reloadTerrain(std::string fileName);
+    void reloadShader(unsigned int index);
+    void reloadTexture(unsigned int index, std::string fileName);
+
     QOpenGLContext *mContext{nullptr};  //Our OpenGL context
     bool mInitialized{false};
 
     std::vector<Shader*> mShaders;    //holds pointer the GLSL shader program
+    std::vector<std::pair<std::string, std::string>> mShaderFiles;  //vertex and fragment file for each shader
     std::vector<Texture*> mTextures;
     static const int uniforms = 2;
     std::vector<GLint> mMMatrixUniform;          //OpenGL reference to the Uniform in the shader program
@@ -0,0 +1,145 @@
+#include "scenequerybatch.h"
+#include "jobsystem.h"
+
+namespace
+{
+//Fewer queries than this pr job and the job overhead costs more than it saves
+const size_t QueryGrainSize = 64;
+}
+
+void SceneQueryBatch::setup(PxScene* scene, PxU32 raycasts, PxU32 sweeps, PxU32 overlaps)
+{
+    mScene = scene;
+    mRaycasts.reserve(raycasts);
+    mRaycastResults.reserve(raycasts);
+    mSweeps.reserve(sweeps);
+    mSweepResults.reserve(sweeps);
+    mOverlaps.reserve(overlaps);
+    mOverlapResults.reserve(overlaps);
+}
+
+PxU32 SceneQueryBatch::raycast(const PxVec3& origin, const PxVec3& unitDirection, PxReal distance, const PxQueryFilterData& filter)
+{
+    mRaycasts.push_back({origin, unitDirection, distance, filter});
+    return static_cast<PxU32>(mRaycasts.size() - 1);
+}
+
+PxU32 SceneQueryBatch::sweep(const PxGeometry& geometry, const PxTransform& pose, const PxVec3& unitDirection, PxReal distance, const PxQueryFilterData& filter)
+{
+    mSweeps.push_back({PxGeometryHolder(geometry), pose, unitDirection, distance, filter});
+    return static_cast<PxU32>(mSweeps.size() - 1);
+}
+
+PxU32 SceneQueryBatch::overlap(const PxGeometry& geometry, const PxTransform& pose, const PxQueryFilterData& filter)
+{
+    mOverlaps.push_back({PxGeometryHolder(geometry), pose, filter});
+    return static_cast<PxU32>(mOverlaps.size() - 1);
+}
+
+template<typename T>
+void SceneQueryBatch::copyHit(const T& hit, Hit& result)
+{
+    result.bHit = true;
+    result.actor = hit.actor;
+    result.shape = hit.shape;
+    result.position = hit.position;
+    result.normal = hit.normal;
+    result.distance = hit.distance;
+}
+
+//false if the query only wants statics, then the region scenes have nothing for it
+bool SceneQueryBatch::regionFilter(const PxQueryFilterData& filter, PxQueryFilterData& result)
+{
+    result = filter;
+    result.flags &= ~PxQueryFlags(PxQueryFlag::eSTATIC);
+    return result.flags.isSet(PxQueryFlag::eDYNAMIC);
+}
+
+void SceneQueryBatch::execute()
+{
+    if(!mScene)
+        return;
+    JobSystem* jobs = JobSystem::getInstance();
+
+    mRaycastResults.resize(mRaycasts.size());
+    jobs->parallelFor(mRaycasts.size(), [this](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const Raycast& query = mRaycasts[i];
+            PxRaycastBuffer buffer;
+            mRaycastResults[i] = Hit();
+            if(mScene->raycast(query.origin, query.direction, query.distance, buffer, PxHitFlag::eDEFAULT, query.filter) && buffer.hasBlock)
+                copyHit(buffer.block, mRaycastResults[i]);
+            PxQueryFilterData filter;
+            if(mRegionScenes.empty() || !regionFilter(query.filter, filter))
+                continue;
+            for(PxScene* scene : mRegionScenes)
+            {
+                //nothing past the hit so far can win
+                PxReal distance = mRaycastResults[i].bHit ? mRaycastResults[i].distance : query.distance;
+                if(scene->raycast(query.origin, query.direction, distance, buffer, PxHitFlag::eDEFAULT, filter) && buffer.hasBlock
+                   && (!mRaycastResults[i].bHit || buffer.block.distance < mRaycastResults[i].distance))
+                    copyHit(buffer.block, mRaycastResults[i]);
+            }
+        }
+    }, QueryGrainSize);
+
+    mSweepResults.resize(mSweeps.size());
+    jobs->parallelFor(mSweeps.size(), [this](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const Sweep& query = mSweeps[i];
+            PxSweepBuffer buffer;
+            mSweepResults[i] = Hit();
+            if(mScene->sweep(query.geometry.any(), query.pose, query.direction, query.distance, buffer, PxHitFlag::eDEFAULT, query.filter) && buffer.hasBlock)
+                copyHit(buffer.block, mSweepResults[i]);
+            PxQueryFilterData filter;
+            if(mRegionScenes.empty() || !regionFilter(query.filter, filter))
+                continue;
+            for(PxScene* scene : mRegionScenes)
+            {
+                PxReal distance = mSweepResults[i].bHit ? mSweepResults[i].distance : query.distance;
+                if(scene->sweep(query.geometry.any(), query.pose, query.direction, distance, buffer, PxHitFlag::eDEFAULT, filter) && buffer.hasBlock
+                   && (!mSweepResults[i].bHit || buffer.block.distance < mSweepResults[i].distance))
+                    copyHit(buffer.block, mSweepResults[i]);
+            }
+        }
+    }, QueryGrainSize);
+
+    mOverlapResults.resize(mOverlaps.size());
+    jobs->parallelFor(mOverlaps.size(), [this](size_t begin, size_t end)
+    {
+        //Overlaps only report touches, and need somewhere to put them
+        PxOverlapHit touches[MaxOverlapHits];
+        for(size_t i = begin; i < end; i++)
+        {
+            const OverlapQuery& query = mOverlaps[i];
+            PxOverlapBuffer buffer(touches, MaxOverlapHits);
+            PxQueryFilterData filter = query.filter;
+            filter.flags |= PxQueryFlag::eNO_BLOCK;
+            Overlap& result = mOverlapResults[i];
+            result = Overlap();
+            mScene->overlap(query.geometry.any(), query.pose, buffer, filter);
+            result.count = buffer.getNbTouches();
+            for(PxU32 hit = 0; hit < result.count; hit++)
+                result.actors[hit] = touches[hit].actor;
+            if(mRegionScenes.empty() || !regionFilter(filter, filter))
+                continue;
+            for(PxScene* scene : mRegionScenes)
+            {
+                if(result.count == MaxOverlapHits)
+                    break;
+                PxOverlapBuffer regionBuffer(touches, MaxOverlapHits - result.count);
+                scene->overlap(query.geometry.any(), query.pose, regionBuffer, filter);
+                for(PxU32 hit = 0; hit < regionBuffer.getNbTouches(); hit++)
+                    result.actors[result.count++] = touches[hit].actor;
+            }
+        }
+    }, QueryGrainSize);
+
+    mRaycasts.clear();
+    mSweeps.clear();
+    mOverlaps.clear();
+}
@@ -0,0 +1,97 @@
+#ifndef SCENEQUERYBATCH_H
+#define SCENEQUERYBATCH_H
+
+#include <vector>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Collects raycasts, sweeps and overlaps during the frame and runs them all at once on the
+//JobSystem after fetchResults(), when the scene is safe to read from many threads.
+//Submitting gives back an index. After execute() the result for that index is in the result
+//arrays and stays there until the next execute(), so gameplay reads last step's answers
+//while it queues up the next ones.
+//The arrays are sized by setup() and only grow if a frame asks for more than that.
+//With RegionGrid on, the dynamics live in the region scenes, those are asked too and the nearest
+//hit wins. A hit near a border can be a body's ghost, which has the same name and userData.
+class SceneQueryBatch
+{
+public:
+    static constexpr PxU32 MaxOverlapHits = 8;
+
+    struct Hit
+    {
+        bool bHit {false};
+        PxRigidActor* actor {nullptr};
+        PxShape* shape {nullptr};
+        PxVec3 position {0.f, 0.f, 0.f};
+        PxVec3 normal {0.f, 0.f, 0.f};
+        PxReal distance {0.f};
+    };
+
+    struct Overlap
+    {
+        PxU32 count {0};                        //at most MaxOverlapHits, the rest are dropped
+        PxRigidActor* actors[MaxOverlapHits] {};
+    };
+
+    void setup(PxScene* scene, PxU32 raycasts, PxU32 sweeps, PxU32 overlaps);
+    //Scenes that only hold dynamics for the queries, their statics are copies of the main scene's
+    void setRegionScenes(const std::vector<PxScene*>& scenes){mRegionScenes = scenes;}
+
+    //All of these only queue the query and return the index of its result
+    PxU32 raycast(const PxVec3& origin, const PxVec3& unitDirection, PxReal distance,
+                  const PxQueryFilterData& filter = PxQueryFilterData());
+    PxU32 sweep(const PxGeometry& geometry, const PxTransform& pose, const PxVec3& unitDirection, PxReal distance,
+                const PxQueryFilterData& filter = PxQueryFilterData());
+    PxU32 overlap(const PxGeometry& geometry, const PxTransform& pose,
+                  const PxQueryFilterData& filter = PxQueryFilterData());
+
+    //Runs everything queued since the last call. Must not overlap with simulate()
+    void execute();
+
+    const Hit& raycastResult(PxU32 index) const {return mRaycastResults[index];}
+    const Hit& sweepResult(PxU32 index) const {return mSweepResults[index];}
+    const Overlap& overlapResult(PxU32 index) const {return mOverlapResults[index];}
+    PxU32 raycastCount() const {return static_cast<PxU32>(mRaycastResults.size());}
+    PxU32 sweepCount() const {return static_cast<PxU32>(mSweepResults.size());}
+    PxU32 overlapCount() const {return static_cast<PxU32>(mOverlapResults.size());}
+
+private:
+    struct Raycast
+    {
+        PxVec3 origin;
+        PxVec3 direction;
+        PxReal distance;
+        PxQueryFilterData filter;
+    };
+    struct Sweep
+    {
+        PxGeometryHolder geometry;
+        PxTransform pose;
+        PxVec3 direction;
+        PxReal distance;
+        PxQueryFilterData filter;
+    };
+    struct OverlapQuery
+    {
+        PxGeometryHolder geometry;
+        PxTransform pose;
+        PxQueryFilterData filter;
+    };
+
+    template<typename T>
+    static void copyHit(const T& hit, Hit& result);
+    static bool regionFilter(const PxQueryFilterData& filter, PxQueryFilterData& result);
+
+    PxScene* mScene {nullptr};
+    std::vector<PxScene*> mRegionScenes;
+    std::vector<Raycast> mRaycasts;
+    std::vector<Sweep> mSweeps;
+    std::vector<OverlapQuery> mOverlaps;
+    std::vector<Hit> mRaycastResults;
+    std::vector<Hit> mSweepResults;
+    std::vector<Overlap> mOverlapResults;
+};
+
+#endif // SCENEQUERYBATCH_H
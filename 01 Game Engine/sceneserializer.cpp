@@ -0,0 +1,134 @@
+#include "sceneserializer.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+void SceneSerializer::setup(PxPhysics* physics)
+{
+    mPhysics = physics;
+    mRegistry = PxSerialization::createSerializationRegistry(*physics);
+}
+
+void SceneSerializer::release()
+{
+    if(mRegistry)
+        mRegistry->release();
+    mRegistry = nullptr;
+}
+
+PxSerialObjectId SceneSerializer::id(const char* name)
+{
+    //64 bit FNV-1a, 0 means "no id" to PhysX so it is never given out
+    PxU64 hash = 14695981039346656037ull;
+    for(const char* c = name; *c; c++)
+    {
+        hash ^= static_cast<unsigned char>(*c);
+        hash *= 1099511628211ull;
+    }
+    return hash == PX_SERIAL_OBJECT_ID_INVALID ? 1 : hash;
+}
+
+std::string SceneSerializer::stamped(const std::string& fileName, const std::vector<std::string>& sources, const std::string& key)
+{
+    PxU64 hash = 14695981039346656037ull;
+    for(char c : key)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    for(const std::string& source : sources)
+    {
+        QFile file(QString::fromStdString(source));
+        if(!file.open(QIODevice::ReadOnly))
+            continue;
+        const QByteArray bytes = file.readAll();
+        for(char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+    }
+    char stamp[20];
+    std::snprintf(stamp, sizeof(stamp), "-%016llx", static_cast<unsigned long long>(hash));
+    const size_t dot = fileName.find_last_of('.');
+    const size_t slash = fileName.find_last_of("/\\");
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return fileName + stamp;
+    return fileName.substr(0, dot) + stamp + fileName.substr(dot);
+}
+
+bool SceneSerializer::exportScene(PxScene* scene, const std::string& fileName, const std::vector<PxRigidDynamic*>& extraBodies)
+{
+    if(!mRegistry)
+        return false;
+    PxCollection* collection = PxCreateCollection();
+    PxActorTypeFlags types = PxActorTypeFlag::eRIGID_STATIC | PxActorTypeFlag::eRIGID_DYNAMIC;
+    std::vector<PxActor*> actors(scene->getNbActors(types));
+    scene->getActors(types, actors.data(), static_cast<PxU32>(actors.size()));
+    actors.insert(actors.end(), extraBodies.begin(), extraBodies.end());
+    for(PxActor* actor : actors)
+    {
+        //Only the first actor of a name can be found again by it, the rest are stored without an id
+        const char* name = actor->getName();
+        if(name && *name && !collection->find(id(name)))
+            collection->add(*actor, id(name));
+        else
+            collection->add(*actor);
+    }
+    std::vector<PxConstraint*> constraints(scene->getNbConstraints());
+    scene->getConstraints(constraints.data(), static_cast<PxU32>(constraints.size()));
+    for(PxConstraint* constraint : constraints)
+    {
+        PxU32 type;
+        PxBase* joint = static_cast<PxBase*>(constraint->getExternalReference(type));
+        if(joint && type == PxConstraintExtIDs::eJOINT)
+            collection->add(*joint);
+    }
+    //Pulls in the shapes, meshes and materials the actors use
+    PxSerialization::complete(*collection, *mRegistry);
+
+    bool bSaved = false;
+    if(PxSerialization::isSerializable(*collection, *mRegistry))
+    {
+        PxDefaultFileOutputStream output(fileName.c_str());
+        bSaved = output.isValid() && PxSerialization::serializeCollectionToBinary(output, *collection, *mRegistry, nullptr, true);
+    }
+    if(!bSaved)
+        std::cerr << "Could not save the scene to " << fileName << "\n";
+    collection->release();
+    return bSaved;
+}
+
+PxCollection* SceneSerializer::importScene(const std::string& fileName)
+{
+    if(!mRegistry)
+        return nullptr;
+    std::unique_ptr<QFile> file = std::make_unique<QFile>(QString::fromStdString(fileName));
+    if(!file->open(QIODevice::ReadOnly) || file->size() == 0)
+        return nullptr;
+
+    //PhysX patches pointers inside the buffer, a private mapping keeps those writes off the disk
+    uchar* memory = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+    if(!memory)
+        return nullptr;
+    if(reinterpret_cast<std::uintptr_t>(memory) % PX_SERIAL_FILE_ALIGN != 0)
+    {
+        //Mappings start on a page, this is only here in case a platform does it differently
+        std::unique_ptr<PxU8[]> copy(new PxU8[file->size() + PX_SERIAL_FILE_ALIGN]);
+        PxU8* aligned = reinterpret_cast<PxU8*>((reinterpret_cast<std::uintptr_t>(copy.get()) + PX_SERIAL_FILE_ALIGN - 1) & ~std::uintptr_t(PX_SERIAL_FILE_ALIGN - 1));
+        std::memcpy(aligned, memory, file->size());
+        file->unmap(memory);
+        memory = aligned;
+        mCopies.push_back(std::move(copy));
+    }
+
+    PxCollection* collection = PxSerialization::createCollectionFromBinary(memory, *mRegistry);
+    if(!collection)
+    {
+        std::cerr << fileName << " is not a scene saved by this PhysX version\n";
+        return nullptr;
+    }
+    mMappedFiles.push_back(std::move(file));
+    return collection;
+}
@@ -0,0 +1,44 @@
+#ifndef SCENESERIALIZER_H
+#define SCENESERIALIZER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <QFile>
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//Saves a fully built scene (actors, shapes, meshes, materials, joints) as a binary PxCollection
+//and loads it back without cooking anything. The file is memory mapped and PhysX builds its
+//objects in place, so the mapping has to stay alive for as long as those objects do.
+//Named actors are stored under id(name), which is how the engine finds them again.
+class SceneSerializer
+{
+public:
+    void setup(PxPhysics* physics);
+    //Gives back the serialization registry. The mapped files are let go in the destructor,
+    //which has to run after PxPhysics::release()
+    void release();
+
+    //extraBodies are saved along with the scene, for dynamics that live in other scenes (RegionGrid)
+    bool exportScene(PxScene* scene, const std::string& fileName,
+                     const std::vector<PxRigidDynamic*>& extraBodies = std::vector<PxRigidDynamic*>());
+    //The collection is the caller's, release it when done looking things up in it.
+    //Its objects are not added to any scene yet
+    PxCollection* importScene(const std::string& fileName);
+
+    static PxSerialObjectId id(const char* name);
+    //fileName with a hash of the sources' contents (and key) put in front of the extension, so a level
+    //saved from other assets or settings is simply not found and everything gets cooked again
+    static std::string stamped(const std::string& fileName, const std::vector<std::string>& sources,
+                               const std::string& key = std::string());
+
+private:
+    PxPhysics* mPhysics {nullptr};
+    PxSerializationRegistry* mRegistry {nullptr};
+    std::vector<std::unique_ptr<QFile>> mMappedFiles;
+    std::vector<std::unique_ptr<PxU8[]>> mCopies;   //only if a mapping ever comes back unaligned
+};
+
+#endif // SCENESERIALIZER_H
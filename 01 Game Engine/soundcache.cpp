@@ -0,0 +1,86 @@
+#include "soundcache.h"
+#include "audiofile.h"
+#include "audioengine.h"
+
+SoundCache* SoundCache::getInstance()
+{
+    static SoundCache instance;
+    return &instance;
+}
+
+SoundBuffer* SoundCache::acquire(const std::string& file)
+{
+    auto found = mSounds.find(file);
+    if(found != mSounds.end())
+    {
+        found->second->references++;
+        return found->second.get();
+    }
+
+    SoundBuffer* sound = new SoundBuffer;
+    sound->file = file;
+    sound->references = 1;
+    mSounds.emplace(file, std::unique_ptr<SoundBuffer>(sound));
+
+    //A file that fails to load still goes through the finish step (closed), so the entry always
+    //hears how it went. The worker only maps and parses, alBufferData() on the audio thread reads
+    //straight from the mapping
+    AssetManager::getInstance()->load<AudioFile>([file]() -> AudioFile*
+    {
+        AudioFile* data = new AudioFile;
+        data->open(file);
+        return data;
+    },
+    [this, sound](AudioFile* data)
+    {
+        //everyone let go while it was loading
+        if(sound->references == 0)
+        {
+            delete data;
+            erase(sound);
+            return false;
+        }
+        if(!data->data())
+        {
+            sound->state = AssetState::Failed;
+            delete data;
+            return false;
+        }
+        //the AL buffer is made on the audio thread, which deletes the file after
+        sound->buffer = AudioEngine::getInstance()->upload(data);
+        sound->state = sound->buffer ? AssetState::Ready : AssetState::Failed;
+        return sound->buffer != 0;
+    });
+    return sound;
+}
+
+void SoundCache::release(SoundBuffer* sound)
+{
+    if(!sound || --sound->references > 0)
+        return;
+    //still decoding, the finish step above cleans it up
+    if(sound->state == AssetState::Loading)
+        return;
+    erase(sound);
+}
+
+void SoundCache::erase(SoundBuffer* sound)
+{
+    //the voices still playing it are stopped first, on the audio thread
+    if(sound->buffer)
+        AudioEngine::getInstance()->deleteBuffer(sound->buffer);
+    mSounds.erase(sound->file);
+}
+
+void SoundCache::clear()
+{
+    for(auto& entry : mSounds)
+    {
+        SoundBuffer& sound = *entry.second;
+        if(!sound.buffer)
+            continue;
+        AudioEngine::getInstance()->deleteBuffer(sound.buffer);
+        sound.buffer = 0;
+        sound.state = AssetState::Failed;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SOUNDCACHE_H
+#define SOUNDCACHE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "AL/al.h"
+#include "assetmanager.h"
+
+//One decoded sound file in one AL buffer, shared by every SoundComponent that plays it
+struct SoundBuffer
+{
+    std::string file;
+    ALuint buffer {0};      //AudioEngine::upload() handle, 0 until it has been decoded
+    AssetState state {AssetState::Loading};
+    int references {0};
+    bool isReady() const {return state == AssetState::Ready;}
+};
+
+//Short sounds: loads every sound file once (see AudioFile), long ones should go through AudioStream. The loading runs on the JobSystem through the AssetManager,
+//AssetManager::update() then hands the file to the AudioEngine, which makes the AL buffer on its thread.
+//Everything handed out carries one reference for the caller, give it back with release().
+//The buffer is deleted when the last reference is gone.
+//Only used from the owning (GUI) thread
+class SoundCache
+{
+public:
+    static SoundCache* getInstance();
+
+    SoundBuffer* acquire(const std::string& file);
+    void release(SoundBuffer* sound);
+    //Deletes every AL buffer, before the AudioEngine closes the device.
+    //SoundBuffers still held just stay silent
+    void clear();
+
+    size_t size() const {return mSounds.size();}
+
+private:
+    SoundCache() {}
+    void erase(SoundBuffer* sound);
+
+    std::unordered_map<std::string, std::unique_ptr<SoundBuffer>> mSounds;
+};
+
+#endif // SOUNDCACHE_H
@@ -3,43 +3,40 @@
 #include <iostream>
 #include "AL/al.h"
 #include "AL/alc.h"
-#include "dr_wav.h"
 #include <vector>
 #include <QVector3D>
+#include "audioengine.h"
+#include "soundcache.h"
 
+//Sound for a GameObject. The buffers come from the SoundCache (shared with every other
+//component playing the same file), sources from the AudioEngine pool while the sound plays,
+//so a silent component costs no source
 class SoundComponent
 {
 public:
     SoundComponent(const char* soundfile);
     SoundComponent(const char* soundfile, QVector3D position, QVector3D soundSource);
     ~SoundComponent();
-    void findDevice();
+    //Same listener for every component, it is just passed on to the AudioEngine
     void setListener(ALfloat posx, ALfloat posy, ALfloat posz);
     void setupMono(const char* soundfile, ALfloat srcx, ALfloat srcy, ALfloat srcz);
     void setupStereo(const char* soundfile);
+    //Every call starts a new voice, so quick repeats overlap instead of cutting each other off.
+    //Does nothing until the SoundCache has the file loaded
     void playMono();
+    //Starts at position and keeps it for the next ones, the voices already playing stay where they are
+    void playMono(const QVector3D& position);
     void playStereo();
+    //Moves the latest voice too. RenderWindow keeps it on the GameObject every frame
+    void setPosition(const QVector3D& position);
+    //How much this sound matters when there are more voices than sources, see AudioEngine
+    void setPriority(float priority){mPriority = priority;}
 private:
-    ALCdevice* mDevice;
-    ALCcontext* mContext;
-    const ALfloat forwardAndUpVectors[6] =
-    {
-       0.f, 1.f, 0.f,
-       0.f, 0.f, 1.f
-    };
-    struct ReadWavData
-    {
-        unsigned int channels = 0;
-        unsigned int sampleRate = 0;
-        drwav_uint64 totalPCMFrameCount = 0;
-        std::vector<uint16_t> pcmData;
-        drwav_uint64 getTotalSamples() { return totalPCMFrameCount * channels; }
-    };
-    ALuint mMonoSoundBuffer;
-    ALuint mStereoSoundBuffer;
-    ALuint mMonoSource;
-    ALuint mStereoSource;
-    QVector3D soundVelocity {0.f, 0.f, 0.f};
+    SoundBuffer* mMonoSound {nullptr};
+    SoundBuffer* mStereoSound {nullptr};
+    QVector3D mPosition {0.f, 0.f, 0.f};
+    float mPriority {1.f};
+    Voice mMonoVoice;       //the latest one, moves along with setPosition()
 };
 
 #endif // SOUNDCOMPONENT_H
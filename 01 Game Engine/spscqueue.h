@@ -0,0 +1,46 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+//Fixed size ring for exactly one thread pushing and one thread popping, no locks.
+//Each side only writes its own index, the other index is read with acquire so the
+//item written before it is visible. Capacity has to be a power of two
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity has to be a power of two");
+
+public:
+    //False when full, the item is not pushed
+    bool push(const T& item)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if(tail - mHead.load(std::memory_order_acquire) == Capacity)
+            return false;
+        mItems[tail & (Capacity - 1)] = item;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if(head == mTail.load(std::memory_order_acquire))
+            return false;
+        item = mItems[head & (Capacity - 1)];
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);}
+
+private:
+    T mItems[Capacity];
+    //on their own cache lines, so the two threads don't keep stealing the line from each other
+    alignas(64) std::atomic<size_t> mHead {0};
+    alignas(64) std::atomic<size_t> mTail {0};
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,110 @@
+#include "terrainshape.h"
+#include <QImage>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//Sorted unique values, merging values closer than epsilon
+std::vector<PxReal> uniqueValues(std::vector<PxReal> values, PxReal epsilon)
+{
+    std::sort(values.begin(), values.end());
+    std::vector<PxReal> unique;
+    for(PxReal value : values)
+    {
+        if(unique.empty() || value - unique.back() > epsilon)
+            unique.push_back(value);
+    }
+    return unique;
+}
+
+//True if the values are evenly spaced, gives back the spacing
+bool uniformSpacing(const std::vector<PxReal>& values, PxReal epsilon, PxReal& spacing)
+{
+    if(values.size() < 2)
+        return false;
+    spacing = (values.back() - values.front()) / (values.size() - 1);
+    for(size_t i = 0; i < values.size(); i++)
+    {
+        if(std::abs(values.front() + i * spacing - values[i]) > epsilon)
+            return false;
+    }
+    return spacing > epsilon;
+}
+}
+
+bool HeightGrid::fromVertices(const std::vector<Vertex>& vertices, HeightGrid& grid)
+{
+    if(vertices.size() < 4)
+        return false;
+
+    std::vector<PxReal> xs, ys;
+    xs.reserve(vertices.size());
+    ys.reserve(vertices.size());
+    PxReal extent = 0.f;
+    for(const Vertex& vertex : vertices)
+    {
+        xs.push_back(vertex.getX());
+        ys.push_back(vertex.getY());
+        extent = std::max(extent, std::max(std::abs(vertex.getX()), std::abs(vertex.getY())));
+    }
+    const PxReal epsilon = std::max(extent, 1.f) * 1e-4f;
+    std::vector<PxReal> columnValues = uniqueValues(xs, epsilon);
+    std::vector<PxReal> rowValues = uniqueValues(ys, epsilon);
+    PxReal dx, dy;
+    if(!uniformSpacing(columnValues, epsilon, dx) || !uniformSpacing(rowValues, epsilon, dy))
+        return false;
+
+    grid.columns = static_cast<PxU32>(columnValues.size());
+    grid.rows = static_cast<PxU32>(rowValues.size());
+    grid.columnScale = dx;
+    grid.rowScale = dy;
+    grid.origin = PxVec3(columnValues.front(), rowValues.front(), 0.f);
+    grid.heights.assign(size_t(grid.rows) * grid.columns, 0.f);
+
+    std::vector<bool> filled(grid.heights.size(), false);
+    for(const Vertex& vertex : vertices)
+    {
+        long column = std::lround((vertex.getX() - grid.origin.x) / dx);
+        long row = std::lround((vertex.getY() - grid.origin.y) / dy);
+        if(column < 0 || row < 0 || column >= long(grid.columns) || row >= long(grid.rows))
+            return false;
+        size_t index = size_t(row) * grid.columns + size_t(column);
+        //the same grid point showing up with two heights means overhangs/cliffs, not a height field
+        if(filled[index] && std::abs(grid.heights[index] - vertex.getZ()) > epsilon)
+            return false;
+        grid.heights[index] = vertex.getZ();
+        filled[index] = true;
+    }
+    //and every grid point has to be there
+    return std::find(filled.begin(), filled.end(), false) == filled.end();
+}
+
+bool HeightGrid::fromImage(const std::string& fileName, PxReal cellSize, PxReal maxHeight, HeightGrid& grid)
+{
+    QImage image(QString::fromStdString(fileName));
+    if(image.isNull() || image.width() < 2 || image.height() < 2)
+        return false;
+    image = image.convertToFormat(QImage::Format_Grayscale8);
+
+    grid.columns = static_cast<PxU32>(image.width());
+    grid.rows = static_cast<PxU32>(image.height());
+    grid.columnScale = cellSize;
+    grid.rowScale = cellSize;
+    grid.origin = PxVec3(0.f, 0.f, 0.f);
+    grid.heights.resize(size_t(grid.rows) * grid.columns);
+    for(PxU32 row = 0; row < grid.rows; row++)
+    {
+        const uchar* line = image.constScanLine(static_cast<int>(row));
+        for(PxU32 column = 0; column < grid.columns; column++)
+            grid.heights[size_t(row) * grid.columns + column] = line[column] / 255.f * maxHeight;
+    }
+    return true;
+}
+
+PxGeometryHolder TerrainShape::geometry() const
+{
+    if(heightField)
+        return PxGeometryHolder(PxHeightFieldGeometry(heightField, PxMeshGeometryFlags(), heightScale, rowScale, columnScale));
+    return PxGeometryHolder(PxTriangleMeshGeometry(triangleMesh));
+}
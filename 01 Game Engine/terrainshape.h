@@ -0,0 +1,43 @@
+#ifndef TERRAINSHAPE_H
+#define TERRAINSHAPE_H
+
+#include <string>
+#include <vector>
+#include <PxPhysicsAPI.h>
+#include "vertex.h"
+
+using namespace physx;
+
+//Regular grid of heights. Z is up in this engine, so rows run along world Y
+//and columns along world X.
+struct HeightGrid
+{
+    PxU32 rows {0};
+    PxU32 columns {0};
+    PxReal rowScale {1.f};          //distance between rows (Y)
+    PxReal columnScale {1.f};       //distance between columns (X)
+    PxVec3 origin {0.f, 0.f, 0.f};  //world position of row 0, column 0
+    std::vector<PxReal> heights;    //rows*columns, row major
+
+    //Works when every vertex sits on a uniformly spaced XY grid with one height per grid point,
+    //which is what terrain.txt is
+    static bool fromVertices(const std::vector<Vertex>& vertices, HeightGrid& grid);
+    //Grayscale heightmap, black is 0 and white is maxHeight
+    static bool fromImage(const std::string& fileName, PxReal cellSize, PxReal maxHeight, HeightGrid& grid);
+};
+
+//The collision for a terrain, either a height field or a triangle mesh
+struct TerrainShape
+{
+    PxHeightField* heightField {nullptr};
+    PxTriangleMesh* triangleMesh {nullptr};
+    PxReal heightScale {1.f};
+    PxReal rowScale {1.f};
+    PxReal columnScale {1.f};
+    PxTransform localPose {PxIdentity};     //the shape's pose on the actor
+
+    bool valid() const {return heightField || triangleMesh;}
+    PxGeometryHolder geometry() const;
+};
+
+#endif // TERRAINSHAPE_H